@@ -0,0 +1,129 @@
+#include <set>
+#include "animation.hpp"
+
+//digits of frame numbers appended to file names without a run of #
+#define FRAME_DIGITS 4
+
+//keys of one target and action in the order of their frames
+std::vector<AnimationKey const*> channel_keys(Scene const& scene, std::string const& target, std::string const& action) {
+	std::vector<AnimationKey const*> keys;
+
+	for (AnimationKey const& key : scene.keys) {
+		if (target == key.target && action == key.action) {
+			keys.push_back(&key);
+		}
+	}
+	return keys;
+}
+
+//interpolates linearly between the keys around the frame and holds the first and last key outside of them
+std::vector<float> interpolate(std::vector<AnimationKey const*> const& keys, unsigned frame) {
+	if (frame <= keys.front()->frame) {
+		return keys.front()->values;
+	}
+	if (frame >= keys.back()->frame) {
+		return keys.back()->values;
+	}
+	unsigned next = 1;
+
+	while (keys[next]->frame <= frame) {
+		++next;
+	}
+	AnimationKey const& before = *keys[next - 1];
+	AnimationKey const& after = *keys[next];
+	float t = (float) (frame - before.frame) / (after.frame - before.frame);
+	std::vector<float> values = before.values;
+
+	for (unsigned i = 0; i < std::min(values.size(), after.values.size()); ++i) {
+		values[i] += t * (after.values[i] - before.values[i]);
+	}
+	return values;
+}
+
+void apply_frame(Scene& scene, unsigned frame) {
+	std::set<std::string> shape_names;
+
+	for (AnimationKey const& key : scene.keys) {
+		if ("camera" != key.action) {
+			shape_names.insert(key.target);
+		}
+	}
+	for (std::string const& name : shape_names) {
+		std::shared_ptr<Shape> shape = scene.root->find_child(name);
+
+		//load_scene has already reported keys of unknown shapes
+		if (nullptr == shape) {
+			continue;
+		}
+		glm::mat4 transformation = scene.rest_transforms.emplace(name, shape->world_transform()).first->second;
+		std::vector<AnimationKey const*> translations = channel_keys(scene, name, "translate");
+		std::vector<AnimationKey const*> rotations = channel_keys(scene, name, "rotate");
+		std::vector<AnimationKey const*> scales = channel_keys(scene, name, "scale");
+
+		//applies the keys in the order a shape is usually placed with transform commands
+		if (!translations.empty()) {
+			std::vector<float> v = interpolate(translations, frame);
+			v.resize(3, 0);
+			transformation = glm::translate(transformation, glm::vec3 {v[0], v[1], v[2]});
+		}
+		if (!rotations.empty()) {
+			std::vector<float> v = interpolate(rotations, frame);
+			v.resize(3, 0);
+			transformation *= glm::eulerAngleYXZ(glm::radians(v[0]), glm::radians(v[1]), glm::radians(v[2]));
+		}
+		if (!scales.empty()) {
+			std::vector<float> v = interpolate(scales, frame);
+			v.resize(3, 1);
+			transformation = glm::scale(transformation, glm::vec3 {v[0], v[1], v[2]});
+		}
+		shape->transform(transformation);
+	}
+	if (!shape_names.empty()) {
+		scene.root->refit();
+	}
+	std::vector<AnimationKey const*> camera_keys = channel_keys(scene, scene.camera.name, "camera");
+
+	if (!camera_keys.empty()) {
+		std::vector<float> v = interpolate(camera_keys, frame);
+
+		if (v.size() >= 7) {
+			scene.camera = make_camera(scene.camera.name, v[0], {v[1], v[2], v[3]}, v[4], v[5], v[6]);
+		}
+	}
+}
+
+std::string frame_file_name(std::string const& file_name, unsigned frame, bool is_sequence) {
+	std::string number = std::to_string(frame);
+	std::size_t last = file_name.find_last_of('#');
+
+	if (std::string::npos != last) {
+		std::size_t first = file_name.find_last_not_of('#', last);
+		first = std::string::npos == first ? 0 : first + 1;
+		std::size_t digits = last + 1 - first;
+		return file_name.substr(0, first) + std::string(digits > number.size() ? digits - number.size() : 0, '0') + number +
+		       file_name.substr(last + 1);
+	}
+	if (!is_sequence) {
+		return file_name;
+	}
+	number = std::string(FRAME_DIGITS > number.size() ? FRAME_DIGITS - number.size() : 0, '0') + number;
+	std::size_t extension = file_name.find_last_of('.');
+	std::size_t directory = file_name.find_last_of('/');
+
+	//a dot in the name of a directory is no extension
+	if (std::string::npos == extension || (std::string::npos != directory && directory > extension)) {
+		return file_name + "_" + number;
+	}
+	return file_name.substr(0, extension) + "_" + number + file_name.substr(extension);
+}
+
+void render_animation(Renderer& renderer, Scene& scene, RenderCommand const& command) {
+	bool is_sequence = command.first_frame != command.last_frame;
+
+	for (unsigned frame = command.first_frame; frame <= command.last_frame; ++frame) {
+		apply_frame(scene, frame);
+		renderer.set_frame(frame);
+		renderer.set_file(frame_file_name(command.file_name, frame, is_sequence));
+		renderer.render(scene);
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef RAYTRACER_ANIMATION_HPP
+#define RAYTRACER_ANIMATION_HPP
+
+#include "renderer.hpp"
+#include "scene.hpp"
+
+/**
+ * Moves the animated shapes and the camera to where their keys put them at the frame.
+ * The keys of a shape are applied on top of the transformation it had before the first frame,
+ * and the hierarchy of the scene is refitted instead of loading the scene again.
+ * Only shapes the root of the scene holds directly can be animated, keys of other shapes are skipped.
+ */
+void apply_frame(Scene& scene, unsigned frame);
+
+//name of the file a frame is saved to, sequences without a run of # in the name get the frame number before the extension
+std::string frame_file_name(std::string const& file_name, unsigned frame, bool is_sequence);
+
+/**
+ * Renders the frames of the command one after the other with the same renderer and thread pool,
+ * so meshes and other assets of the scene are only loaded once for the whole animation.
+ * @param renderer renderer with the image size of the command, whose file and frame are set for each frame
+ */
+void render_animation(Renderer& renderer, Scene& scene, RenderCommand const& command);
+
+#endif
@@ -42,7 +42,7 @@ float Box::volume() const {
 glm::vec3 Box::min(glm::mat4 const& transform) const {
 	glm::mat4 final_transform = transform * world_transform_;
 
-	glm::vec3 min = glm::min(transform_vec(min_, world_transform_), transform_vec(max_, world_transform_));
+	glm::vec3 min = glm::min(transform_vec(min_, final_transform), transform_vec(max_, final_transform));
 	min = glm::min(min, transform_vec(glm::vec3{min_.x, min_.y, max_.z}, final_transform));
 	min = glm::min(min, transform_vec(glm::vec3{min_.x, max_.y, min_.z}, final_transform));
 	min = glm::min(min, transform_vec(glm::vec3{min_.x, max_.y, max_.z}, final_transform));
@@ -55,7 +55,7 @@ glm::vec3 Box::min(glm::mat4 const& transform) const {
 glm::vec3 Box::max(glm::mat4 const& transform) const {
 	glm::mat4 final_transform = transform * world_transform_;
 
-	glm::vec3 max = glm::min(transform_vec(min_, final_transform), transform_vec(max_, final_transform));
+	glm::vec3 max = glm::max(transform_vec(min_, final_transform), transform_vec(max_, final_transform));
 	max = glm::max(max, transform_vec(glm::vec3{min_.x, min_.y, max_.z}, final_transform));
 	max = glm::max(max, transform_vec(glm::vec3{min_.x, max_.y, min_.z}, final_transform));
 	max = glm::max(max, transform_vec(glm::vec3{min_.x, max_.y, max_.z}, final_transform));
@@ -0,0 +1,197 @@
+#include <numeric>
+#include "bvh.hpp"
+#include "threadPool.hpp"
+
+#define BIN_COUNT 12
+//nodes with more primitives build their second subtree in a parallel task
+#define PARALLEL_BUILD_MIN 4096
+
+float surface_area(glm::vec3 const& min, glm::vec3 const& max) {
+	glm::vec3 size = max - min;
+	return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+std::vector<unsigned> Bvh::build(std::vector<glm::vec3> const& mins, std::vector<glm::vec3> const& maxs, unsigned max_leaf_size) {
+	std::vector<unsigned> order(mins.size());
+	std::iota(order.begin(), order.end(), 0);
+	nodes_.clear();
+
+	if (!order.empty()) {
+		nodes_.reserve(2 * order.size() / max_leaf_size + 1);
+		build_node(nodes_, order, 0, order.size(), mins, maxs, max_leaf_size, 1);
+	}
+	nodes_.shrink_to_fit();
+	return order;
+}
+
+unsigned Bvh::build_node(
+		std::vector<BvhNode>& nodes,
+		std::vector<unsigned>& order,
+		unsigned first,
+		unsigned count,
+		std::vector<glm::vec3> const& mins,
+		std::vector<glm::vec3> const& maxs,
+		unsigned max_leaf_size,
+		unsigned depth) {
+	unsigned index = nodes.size();
+	nodes.emplace_back();
+
+	BvhNode node {mins[order[first]], maxs[order[first]], first, count};
+	glm::vec3 centroid_min {std::numeric_limits<float>::infinity()};
+	glm::vec3 centroid_max {-std::numeric_limits<float>::infinity()};
+
+	for (unsigned i = first; i < first + count; ++i) {
+		glm::vec3 centroid = (mins[order[i]] + maxs[order[i]]) * 0.5f;
+		node.min = glm::min(node.min, mins[order[i]]);
+		node.max = glm::max(node.max, maxs[order[i]]);
+		centroid_min = glm::min(centroid_min, centroid);
+		centroid_max = glm::max(centroid_max, centroid);
+	}
+	glm::vec3 extent = centroid_max - centroid_min;
+	int axis = 0;
+
+	if (extent.y > extent[axis]) {
+		axis = 1;
+	}
+	if (extent.z > extent[axis]) {
+		axis = 2;
+	}
+	if (count <= max_leaf_size || depth >= BVH_MAX_DEPTH || 0 == extent[axis]) {
+		nodes[index] = node;
+		return index;
+	}
+	//sorts the primitives into bins along the longest axis by their centroid
+	unsigned bin_counts[BIN_COUNT] {};
+	glm::vec3 bin_mins[BIN_COUNT];
+	glm::vec3 bin_maxs[BIN_COUNT];
+	float bin_scale = BIN_COUNT / extent[axis] * 0.9999f;
+
+	for (int b = 0; b < BIN_COUNT; ++b) {
+		bin_mins[b] = glm::vec3 {std::numeric_limits<float>::infinity()};
+		bin_maxs[b] = glm::vec3 {-std::numeric_limits<float>::infinity()};
+	}
+	auto bin_of = [&](unsigned primitive) {
+		float centroid = (mins[primitive][axis] + maxs[primitive][axis]) * 0.5f;
+		return std::min(BIN_COUNT - 1, (int) ((centroid - centroid_min[axis]) * bin_scale));
+	};
+	for (unsigned i = first; i < first + count; ++i) {
+		int b = bin_of(order[i]);
+		++bin_counts[b];
+		bin_mins[b] = glm::min(bin_mins[b], mins[order[i]]);
+		bin_maxs[b] = glm::max(bin_maxs[b], maxs[order[i]]);
+	}
+	//sweeps from the right to know the cost of every right half before sweeping from the left
+	float right_costs[BIN_COUNT];
+	glm::vec3 right_min = bin_mins[BIN_COUNT - 1];
+	glm::vec3 right_max = bin_maxs[BIN_COUNT - 1];
+	unsigned right_count = 0;
+
+	for (int b = BIN_COUNT - 1; b > 0; --b) {
+		right_min = glm::min(right_min, bin_mins[b]);
+		right_max = glm::max(right_max, bin_maxs[b]);
+		right_count += bin_counts[b];
+		right_costs[b] = 0 == right_count ? 0 : right_count * surface_area(right_min, right_max);
+	}
+	glm::vec3 left_min = bin_mins[0];
+	glm::vec3 left_max = bin_maxs[0];
+	unsigned left_count = 0;
+	float best_cost = std::numeric_limits<float>::infinity();
+	int best_split = 0;
+
+	for (int b = 1; b < BIN_COUNT; ++b) {
+		left_min = glm::min(left_min, bin_mins[b - 1]);
+		left_max = glm::max(left_max, bin_maxs[b - 1]);
+		left_count += bin_counts[b - 1];
+		float cost = (0 == left_count ? 0 : left_count * surface_area(left_min, left_max)) + right_costs[b];
+
+		if (0 != left_count && left_count != count && cost < best_cost) {
+			best_cost = cost;
+			best_split = b;
+		}
+	}
+	unsigned split = first + count / 2;
+
+	if (0 != best_split) {
+		split = std::partition(order.begin() + first, order.begin() + first + count, [&](unsigned primitive) {
+			return bin_of(primitive) < best_split;
+		}) - order.begin();
+	} else {
+		//splits in the middle if all centroids fall into one bin
+		std::nth_element(order.begin() + first, order.begin() + split, order.begin() + first + count, [&](unsigned a, unsigned b) {
+			return mins[a][axis] + maxs[a][axis] < mins[b][axis] + maxs[b][axis];
+		});
+	}
+	node.count = 0;
+
+	if (count < PARALLEL_BUILD_MIN) {
+		build_node(nodes, order, first, split - first, mins, maxs, max_leaf_size, depth + 1);
+		node.offset = build_node(nodes, order, split, first + count - split, mins, maxs, max_leaf_size, depth + 1);
+		nodes[index] = node;
+		return index;
+	}
+	//both halves only reorder their own range of primitives, so the second one can be built into its own array meanwhile
+	ThreadPool& pool = ThreadPool::global();
+	auto second_nodes = pool.submit([&, split, first, count, depth]() {
+		std::vector<BvhNode> sub_nodes;
+		build_node(sub_nodes, order, split, first + count - split, mins, maxs, max_leaf_size, depth + 1);
+		return sub_nodes;
+	});
+	build_node(nodes, order, first, split - first, mins, maxs, max_leaf_size, depth + 1);
+	std::vector<BvhNode> sub_nodes = pool.wait(second_nodes);
+	//appends the second subtree and moves its child references along with it
+	node.offset = nodes.size();
+
+	for (BvhNode& sub_node : sub_nodes) {
+		if (0 == sub_node.count) {
+			sub_node.offset += node.offset;
+		}
+		nodes.push_back(sub_node);
+	}
+	nodes[index] = node;
+	return index;
+}
+
+void Bvh::refit(std::vector<glm::vec3> const& mins, std::vector<glm::vec3> const& maxs) {
+	//children are stored after their parents, so going backwards fits every child before its parent
+	for (unsigned i = nodes_.size(); i-- > 0;) {
+		BvhNode& node = nodes_[i];
+
+		if (0 == node.count) {
+			node.min = glm::min(nodes_[i + 1].min, nodes_[node.offset].min);
+			node.max = glm::max(nodes_[i + 1].max, nodes_[node.offset].max);
+			continue;
+		}
+		node.min = mins[node.offset];
+		node.max = maxs[node.offset];
+
+		for (unsigned j = node.offset + 1; j < node.offset + node.count; ++j) {
+			node.min = glm::min(node.min, mins[j]);
+			node.max = glm::max(node.max, maxs[j]);
+		}
+	}
+}
+
+float Bvh::total_area() const {
+	float area = 0;
+
+	for (BvhNode const& node : nodes_) {
+		area += surface_area(node.min, node.max);
+	}
+	return area;
+}
+
+bool Bvh::empty() const {
+	return nodes_.empty();
+}
+
+glm::vec3 Bvh::min() const {
+	return nodes_.empty() ? glm::vec3 {} : nodes_[0].min;
+}
+
+glm::vec3 Bvh::max() const {
+	return nodes_.empty() ? glm::vec3 {} : nodes_[0].max;
+}
+
+std::size_t Bvh::memory_size() const {
+	return nodes_.size() * sizeof(BvhNode);
+}
@@ -0,0 +1,323 @@
+#ifndef RAYTRACER_BVH_HPP
+#define RAYTRACER_BVH_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "ray.hpp"
+#include "rayPacket.hpp"
+
+//deepest level of the hierarchy, limits the size of the traversal stack
+#define BVH_MAX_DEPTH 64
+
+struct BvhNode {
+	glm::vec3 min {};
+	glm::vec3 max {};
+	//index of the first primitive for leaves, index of the second child for inner nodes (the first child follows directly)
+	unsigned offset = 0;
+	//amount of primitives in a leaf, 0 for inner nodes
+	unsigned count = 0;
+};
+
+/**
+ * Bounding volume hierarchy stored in one flat array that is traversed without recursion.
+ * It only stores indices, so the primitives themselves can be kept in any compact format.
+ */
+class Bvh {
+public:
+	/**
+	 * Builds the hierarchy over the bounding boxes of the primitives with binned surface area heuristic
+	 * @return order in which the primitives have to be stored so every leaf covers a continuous range
+	 */
+	std::vector<unsigned> build(std::vector<glm::vec3> const& mins, std::vector<glm::vec3> const& maxs, unsigned max_leaf_size = 4);
+
+	/**
+	 * Visits all leaves the ray passes closer than closest_t, near leaves first
+	 * @param intersect_leaf called with offset and count of a leaf, can lower closest_t for following leaves
+	 */
+	template<typename LeafIntersector>
+	void traverse(Ray const& ray, float const& closest_t, LeafIntersector const& intersect_leaf) const;
+
+	/**
+	 * Visits all leaves at least one ray of the packet passes closer than its closest_ts entry,
+	 * in the order of the first ray that hits them
+	 * @param closest_ts closest hit distance of each ray, can be lowered by intersect_leaf
+	 * @param intersect_leaf called with offset and count of a leaf and a bit mask of the rays that hit its box
+	 */
+	template<typename LeafIntersector>
+	void traverse_packet(RayPacket const& packet, float const* closest_ts, LeafIntersector const& intersect_leaf) const;
+
+	/**
+	 * Fits the boxes of the nodes around the primitives after they moved, without changing the hierarchy
+	 * @param mins lowest corners of the primitives in the order returned by build
+	 */
+	void refit(std::vector<glm::vec3> const& mins, std::vector<glm::vec3> const& maxs);
+	//sum of the surface areas of all nodes, which grows with the cost of tracing rays through the hierarchy
+	float total_area() const;
+
+	bool empty() const;
+	glm::vec3 min() const;
+	glm::vec3 max() const;
+	std::size_t memory_size() const;
+
+private:
+	std::vector<BvhNode> nodes_;
+
+	unsigned build_node(
+			std::vector<BvhNode>& nodes,
+			std::vector<unsigned>& order,
+			unsigned first,
+			unsigned count,
+			std::vector<glm::vec3> const& mins,
+			std::vector<glm::vec3> const& maxs,
+			unsigned max_leaf_size,
+			unsigned depth);
+};
+
+//https://tavianator.com/2011/ray_box.html
+inline bool intersect_bounds(glm::vec3 const& min, glm::vec3 const& max, glm::vec3 const& origin, glm::vec3 const& dir_inv, float max_t, float& entry_t) {
+	glm::vec3 t1 = (min - origin) * dir_inv;
+	glm::vec3 t2 = (max - origin) * dir_inv;
+	glm::vec3 t_near = glm::min(t1, t2);
+	glm::vec3 t_far = glm::max(t1, t2);
+	entry_t = std::max(std::max(t_near.x, t_near.y), t_near.z);
+	float exit_t = std::min(std::min(t_far.x, t_far.y), t_far.z);
+	return entry_t <= exit_t && exit_t >= 0 && entry_t < max_t;
+}
+
+/**
+ * Bounds of the slab distances of all rays of a packet with a common origin, which allow to reject
+ * a box for the whole packet with one test per axis instead of one test per ray.
+ * Only usable if the direction of every ray has the same sign on every axis.
+ */
+struct PacketInterval {
+	bool is_valid = false;
+	glm::vec3 origin {};
+	glm::vec3 dir_inv_min {};
+	glm::vec3 dir_inv_max {};
+	glm::bvec3 is_negative {};
+
+	PacketInterval(RayPacket const& packet, glm::vec3 const* dir_invs) {
+		if (!packet.has_common_origin || 0 == packet.active_mask) {
+			return;
+		}
+		unsigned first = 0;
+
+		while (!packet.is_active(first)) {
+			++first;
+		}
+		origin = packet.rays[first].origin;
+		dir_inv_min = dir_invs[first];
+		dir_inv_max = dir_invs[first];
+		is_negative = glm::lessThan(dir_invs[first], glm::vec3 {0});
+
+		for (unsigned i = first; i < packet.size; ++i) {
+			if (!packet.is_active(i)) {
+				continue;
+			}
+			for (int axis = 0; axis < 3; ++axis) {
+				if (!std::isfinite(dir_invs[i][axis]) || (dir_invs[i][axis] < 0) != is_negative[axis]) {
+					return;
+				}
+			}
+			dir_inv_min = glm::min(dir_inv_min, dir_invs[i]);
+			dir_inv_max = glm::max(dir_inv_max, dir_invs[i]);
+		}
+		is_valid = true;
+	}
+
+	/**
+	 * Returns false if no ray of the packet can hit the box closer than max_t
+	 * @param entry_t lower bound of the distance at which the rays enter the box
+	 */
+	bool may_hit(glm::vec3 const& min, glm::vec3 const& max, float max_t, float& entry_t) const {
+		entry_t = 0;
+		float exit_t = max_t;
+
+		for (int axis = 0; axis < 3; ++axis) {
+			float near = (is_negative[axis] ? max[axis] : min[axis]) - origin[axis];
+			float far = (is_negative[axis] ? min[axis] : max[axis]) - origin[axis];
+			entry_t = std::max(entry_t, std::min(near * dir_inv_min[axis], near * dir_inv_max[axis]));
+			exit_t = std::min(exit_t, std::max(far * dir_inv_min[axis], far * dir_inv_max[axis]));
+		}
+		return entry_t <= exit_t;
+	}
+};
+
+template<typename LeafIntersector>
+void Bvh::traverse(Ray const& ray, float const& closest_t, LeafIntersector const& intersect_leaf) const {
+	if (nodes_.empty()) {
+		return;
+	}
+	glm::vec3 dir_inv = 1.0f / ray.direction;
+	float entry_t;
+
+	if (!intersect_bounds(nodes_[0].min, nodes_[0].max, ray.origin, dir_inv, closest_t, entry_t)) {
+		return;
+	}
+	//far nodes still to visit together with the distance the ray enters them
+	unsigned stack[BVH_MAX_DEPTH];
+	float stack_t[BVH_MAX_DEPTH];
+	unsigned stack_size = 0;
+	unsigned current = 0;
+
+	while (true) {
+		BvhNode const& node = nodes_[current];
+
+		if (0 != node.count) {
+			intersect_leaf(node.offset, node.count);
+		} else {
+			unsigned near = current + 1;
+			unsigned far = node.offset;
+			float near_t;
+			float far_t;
+			bool near_hit = intersect_bounds(nodes_[near].min, nodes_[near].max, ray.origin, dir_inv, closest_t, near_t);
+			bool far_hit = intersect_bounds(nodes_[far].min, nodes_[far].max, ray.origin, dir_inv, closest_t, far_t);
+
+			if (near_hit && far_hit) {
+				if (far_t < near_t) {
+					std::swap(near, far);
+					std::swap(near_t, far_t);
+				}
+				stack[stack_size] = far;
+				stack_t[stack_size] = far_t;
+				++stack_size;
+				current = near;
+				continue;
+			} else if (near_hit) {
+				current = near;
+				continue;
+			} else if (far_hit) {
+				current = far;
+				continue;
+			}
+		}
+		//skips nodes that are further away than a hit found in the meantime
+		do {
+			if (0 == stack_size) {
+				return;
+			}
+			--stack_size;
+		} while (stack_t[stack_size] >= closest_t);
+		current = stack[stack_size];
+	}
+}
+
+template<typename LeafIntersector>
+void Bvh::traverse_packet(RayPacket const& packet, float const* closest_ts, LeafIntersector const& intersect_leaf) const {
+	if (nodes_.empty() || 0 == packet.active_mask) {
+		return;
+	}
+	glm::vec3 dir_invs[PACKET_SIZE];
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		dir_invs[i] = 1.0f / packet.rays[i].direction;
+	}
+	PacketInterval interval {packet, dir_invs};
+
+	//only rays of the active mask are tested, the others are skipped as if they had already hit something
+	auto max_closest_t = [&]() {
+		float max_t = -std::numeric_limits<float>::infinity();
+
+		for (unsigned i = 0; i < packet.size; ++i) {
+			if (packet.is_active(i)) {
+				max_t = std::max(max_t, closest_ts[i]);
+			}
+		}
+		return max_t;
+	};
+	//entry_t is set to a distance no ray of the packet enters the box before, so it can be used to skip boxes
+	auto packet_hits = [&](BvhNode const& node, float& entry_t) {
+		float ray_entry_t;
+
+		//tests the whole packet at once and then only looks for the first ray that really hits the box
+		if (interval.is_valid) {
+			if (!interval.may_hit(node.min, node.max, max_closest_t(), entry_t)) {
+				return false;
+			}
+			for (unsigned i = 0; i < packet.size; ++i) {
+				if (packet.is_active(i) && intersect_bounds(node.min, node.max, packet.rays[i].origin, dir_invs[i], closest_ts[i], ray_entry_t)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		bool is_hit = false;
+		entry_t = std::numeric_limits<float>::infinity();
+
+		for (unsigned i = 0; i < packet.size; ++i) {
+			if (packet.is_active(i) && intersect_bounds(node.min, node.max, packet.rays[i].origin, dir_invs[i], closest_ts[i], ray_entry_t)) {
+				entry_t = std::min(entry_t, ray_entry_t);
+				is_hit = true;
+			}
+		}
+		return is_hit;
+	};
+	float entry_t;
+
+	if (!packet_hits(nodes_[0], entry_t)) {
+		return;
+	}
+	unsigned stack[BVH_MAX_DEPTH];
+	float stack_t[BVH_MAX_DEPTH];
+	unsigned stack_size = 0;
+	unsigned current = 0;
+
+	while (true) {
+		BvhNode const& node = nodes_[current];
+
+		if (0 != node.count) {
+			//only passes on the rays that reach the leaf, the others would be tested against its primitives for nothing
+			unsigned active_mask = 0;
+			float ray_entry_t;
+
+			for (unsigned i = 0; i < packet.size; ++i) {
+				if (packet.is_active(i) && intersect_bounds(node.min, node.max, packet.rays[i].origin, dir_invs[i], closest_ts[i], ray_entry_t)) {
+					active_mask |= 1u << i;
+				}
+			}
+			if (0 != active_mask) {
+				intersect_leaf(node.offset, node.count, active_mask);
+			}
+		} else {
+			unsigned near = current + 1;
+			unsigned far = node.offset;
+			float near_t;
+			float far_t;
+			bool near_hit = packet_hits(nodes_[near], near_t);
+			bool far_hit = packet_hits(nodes_[far], far_t);
+
+			if (near_hit && far_hit) {
+				if (far_t < near_t) {
+					std::swap(near, far);
+					std::swap(near_t, far_t);
+				}
+				stack[stack_size] = far;
+				stack_t[stack_size] = far_t;
+				++stack_size;
+				current = near;
+				continue;
+			} else if (near_hit) {
+				current = near;
+				continue;
+			} else if (far_hit) {
+				current = far;
+				continue;
+			}
+		}
+		//skips nodes that are further away than the hits of all rays found in the meantime
+		float max_t = max_closest_t();
+
+		do {
+			if (0 == stack_size) {
+				return;
+			}
+			--stack_size;
+		} while (stack_t[stack_size] >= max_t);
+		current = stack[stack_size];
+	}
+}
+
+#endif //RAYTRACER_BVH_HPP
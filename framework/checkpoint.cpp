@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include "checkpoint.hpp"
+
+//marks the files as checkpoints and is raised whenever their layout changes
+static char const CHECKPOINT_MAGIC[] {'R', 'T', 'C', 'K'};
+static uint32_t const CHECKPOINT_VERSION = 2;
+
+template<typename T>
+void write_vector(std::ostream& stream, std::vector<T> const& values) {
+	uint64_t size = values.size();
+	stream.write(reinterpret_cast<char const*>(&size), sizeof(size));
+	stream.write(reinterpret_cast<char const*>(values.data()), size * sizeof(T));
+}
+
+//refuses sizes larger than the rest of the file, so a damaged file cannot make it allocate huge buffers
+template<typename T>
+bool read_vector(std::istream& stream, std::vector<T>& values, uint64_t remaining_bytes) {
+	uint64_t size = 0;
+
+	if (!stream.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > remaining_bytes / sizeof(T)) {
+		return false;
+	}
+	values.resize(size);
+	return (bool) stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+}
+
+bool save_checkpoint(std::string const& file, Checkpoint const& checkpoint) {
+	std::string temp_file = file + ".tmp";
+	{
+		std::ofstream stream(temp_file, std::ios::binary | std::ios::trunc);
+		uint32_t header[] {
+				CHECKPOINT_VERSION, checkpoint.width, checkpoint.height, checkpoint.aa_steps, checkpoint.sample_count,
+				checkpoint.scene_hash, checkpoint.sampler_hash, checkpoint.integrator, checkpoint.render_mode,
+				checkpoint.max_ray_bounces, checkpoint.frame};
+		stream.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+		stream.write(reinterpret_cast<char const*>(header), sizeof(header));
+		write_vector(stream, checkpoint.rects);
+		write_vector(stream, checkpoint.finished_tiles);
+		write_vector(stream, checkpoint.colors);
+		write_vector(stream, checkpoint.accumulation);
+		write_vector(stream, checkpoint.brightness_sums);
+		write_vector(stream, checkpoint.brightness_squares);
+		write_vector(stream, checkpoint.guides);
+
+		if (!stream.flush()) {
+			return false;
+		}
+	}
+	return 0 == std::rename(temp_file.c_str(), file.c_str());
+}
+
+bool load_checkpoint(std::string const& file, Checkpoint& checkpoint) {
+	std::ifstream stream(file, std::ios::binary | std::ios::ate);
+
+	if (!stream) {
+		return false;
+	}
+	uint64_t file_size = stream.tellg();
+	stream.seekg(0);
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	uint32_t header[11];
+
+	if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC) ||
+	    !stream.read(reinterpret_cast<char*>(header), sizeof(header)) || CHECKPOINT_VERSION != header[0]) {
+		return false;
+	}
+	checkpoint.width = header[1];
+	checkpoint.height = header[2];
+	checkpoint.aa_steps = header[3];
+	checkpoint.sample_count = header[4];
+	checkpoint.scene_hash = header[5];
+	checkpoint.sampler_hash = header[6];
+	checkpoint.integrator = header[7];
+	checkpoint.render_mode = header[8];
+	checkpoint.max_ray_bounces = header[9];
+	checkpoint.frame = header[10];
+	return read_vector(stream, checkpoint.rects, file_size) &&
+	       read_vector(stream, checkpoint.finished_tiles, file_size) &&
+	       read_vector(stream, checkpoint.colors, file_size) &&
+	       read_vector(stream, checkpoint.accumulation, file_size) &&
+	       read_vector(stream, checkpoint.brightness_sums, file_size) &&
+	       read_vector(stream, checkpoint.brightness_squares, file_size) &&
+	       read_vector(stream, checkpoint.guides, file_size);
+}
+
+bool same_settings(Checkpoint const& a, Checkpoint const& b) {
+	return a.width == b.width && a.height == b.height && a.aa_steps == b.aa_steps &&
+	       a.scene_hash == b.scene_hash && a.sampler_hash == b.sampler_hash && a.integrator == b.integrator &&
+	       a.render_mode == b.render_mode && a.max_ray_bounces == b.max_ray_bounces && a.frame == b.frame;
+}
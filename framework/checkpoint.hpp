@@ -0,0 +1,51 @@
+#ifndef RAYTRACER_CHECKPOINT_HPP
+#define RAYTRACER_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "color.hpp"
+#include "denoiser.hpp"
+#include "pixelRect.hpp"
+
+/**
+ * State of an unfinished render that a later run can continue from.
+ * Samplers only depend on the pixel, the sample index and the frame, so the sample count is all of their state.
+ */
+struct Checkpoint {
+	unsigned width = 0;
+	unsigned height = 0;
+	unsigned aa_steps = 0;
+	//settings the pixels depend on, a render with other settings does not resume the checkpoint
+	uint32_t scene_hash = 0;
+	uint32_t sampler_hash = 0;
+	unsigned integrator = 0;
+	unsigned render_mode = 0;
+	unsigned max_ray_bounces = 0;
+	unsigned frame = 0;
+	//tiles of a render and which of them are finished, empty for progressive renders
+	std::vector<PixelRect> rects;
+	std::vector<unsigned char> finished_tiles;
+	//passes finished by a progressive render
+	unsigned sample_count = 0;
+	//tone mapped pixels of the finished tiles
+	std::vector<Color> colors;
+	//sums of the samples of a progressive render
+	std::vector<Color> accumulation;
+	std::vector<float> brightness_sums;
+	std::vector<float> brightness_squares;
+	std::vector<GuideSample> guides;
+};
+
+/**
+ * Writes the checkpoint to a temporary file first and then replaces the file with it,
+ * so a crash while saving keeps the previous checkpoint intact
+ * @return false if the file could not be written
+ */
+bool save_checkpoint(std::string const& file, Checkpoint const& checkpoint);
+//@return false if the file does not exist or is no complete checkpoint
+bool load_checkpoint(std::string const& file, Checkpoint& checkpoint);
+//true if both checkpoints belong to renders of the same image size and settings
+bool same_settings(Checkpoint const& a, Checkpoint const& b);
+
+#endif
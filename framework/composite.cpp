@@ -1,14 +1,17 @@
 #include <numeric>
 #include <iomanip>
+#include <limits>
 #include "composite.hpp"
 
 #define EPSILON 0.001f
+//growth of the surface area of a refitted hierarchy after which it is built again
+#define REFIT_MAX_GROWTH 1.5f
 
 Composite::Composite(std::string const& name, std::shared_ptr<Material> material) :
-	Shape(name, material), bounds_{nullptr} {}
+	Shape(name, material), bounds_{nullptr}, built_area_{0}, is_transformed_{false} {}
 
 Composite::Composite(std::shared_ptr<Box> bounds, std::string const& name, std::shared_ptr<Material> material) :
-	Shape(name, material), bounds_{bounds} {}
+	Shape(name, material), bounds_{bounds}, built_area_{0}, is_transformed_{false} {}
 
 float Composite::area() const {
 	float area_sum = 0;
@@ -73,6 +76,28 @@ std::ostream &Composite::print(std::ostream &os) const {
 }
 
 HitPoint Composite::intersect(Ray const& ray) const {
+	if (!primitives_.empty()) {
+		//untransformed composites pass the ray on as it is
+		Ray ray_inv = is_transformed_ ? transform_ray(ray, world_transform_inv_) : ray;
+		float closest_t = std::numeric_limits<float>::infinity();
+		HitPoint closest_hit {};
+
+		bvh_.traverse(ray_inv, closest_t, [&](unsigned offset, unsigned count) {
+			for (unsigned i = offset; i < offset + count; ++i) {
+				HitPoint hit = primitives_[i]->intersect(ray_inv);
+
+				if (hit.does_intersect && hit.distance < closest_t) {
+					closest_t = hit.distance;
+					closest_hit = hit;
+				}
+			}
+		});
+		if (closest_hit.does_intersect && is_transformed_) {
+			closest_hit.position = transform_vec(closest_hit.position, world_transform_);
+			closest_hit.surface_normal = glm::normalize(transform_vec(closest_hit.surface_normal, world_transform_, false));
+		}
+		return closest_hit;
+	}
 	assert(nullptr != bounds_);
 	float t;
 	bool bounds_hit = bounds_->intersect(ray, t);
@@ -102,6 +127,47 @@ HitPoint Composite::intersect(Ray const& ray) const {
 	return min_hit;
 }
 
+void Composite::intersect_packet(RayPacket const& packet, HitPoint* hits) const {
+	if (primitives_.empty()) {
+		Shape::intersect_packet(packet, hits);
+		return;
+	}
+	//distances along the rays are the same in the space of the children, so the hits are collected in place
+	RayPacket packet_inv = is_transformed_ ? transform_packet(packet, world_transform_inv_) : packet;
+	float closest_ts[PACKET_SIZE];
+
+	float previous_ts[PACKET_SIZE];
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		closest_ts[i] = hits[i].does_intersect ? hits[i].distance : std::numeric_limits<float>::infinity();
+		previous_ts[i] = closest_ts[i];
+	}
+	RayPacket leaf_packet = packet_inv;
+
+	bvh_.traverse_packet(packet_inv, closest_ts, [&](unsigned offset, unsigned count, unsigned active_mask) {
+		leaf_packet.active_mask = packet_inv.active_mask & active_mask;
+
+		for (unsigned i = offset; i < offset + count; ++i) {
+			primitives_[i]->intersect_packet(leaf_packet, hits);
+		}
+		for (unsigned i = 0; i < packet.size; ++i) {
+			if (hits[i].does_intersect) {
+				closest_ts[i] = hits[i].distance;
+			}
+		}
+	});
+	if (!is_transformed_) {
+		return;
+	}
+	//moves the hits that were found in this composite back into its parent space
+	for (unsigned i = 0; i < packet.size; ++i) {
+		if (closest_ts[i] != previous_ts[i]) {
+			hits[i].position = transform_vec(hits[i].position, world_transform_);
+			hits[i].surface_normal = glm::normalize(transform_vec(hits[i].surface_normal, world_transform_, false));
+		}
+	}
+}
+
 void Composite::add_child(std::shared_ptr<Shape> shape) {
 	if (children_.end() != children_.find(shape->get_name())) {
 		std::cout << shape->get_name();
@@ -110,7 +176,12 @@ void Composite::add_child(std::shared_ptr<Shape> shape) {
 }
 
 std::shared_ptr<Shape> Composite::find_child(std::string const& name) const {
-	return children_.find(name)->second;
+	auto it = children_.find(name);
+	return children_.end() == it ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<Shape>> const& Composite::primitives() const {
+	return primitives_;
 }
 
 unsigned Composite::child_count() {
@@ -118,6 +189,8 @@ unsigned Composite::child_count() {
 }
 
 void Composite::build_octree() {
+	primitives_.clear();
+	is_transformed_ = glm::mat4() != world_transform_;
 	bounds_ = nullptr;
 	bounds_ = std::make_shared<Box>(min(), max());
 //	bounds_ = std::make_shared<Box>(min(), max(), "bound", std::make_shared<Material>());
@@ -160,6 +233,72 @@ void Composite::build_octree() {
 	}
 }
 
+void Composite::flatten() {
+	std::set<Shape const*> visited;
+	std::vector<std::shared_ptr<Shape>> primitives;
+	collect_primitives(primitives, visited);
+
+	is_transformed_ = glm::mat4() != world_transform_;
+	bounds_ = nullptr;
+	bounds_ = std::make_shared<Box>(min(), max());
+	std::vector<glm::vec3> mins;
+	std::vector<glm::vec3> maxs;
+
+	for (auto const& primitive : primitives) {
+		mins.push_back(primitive->min());
+		maxs.push_back(primitive->max());
+	}
+	std::vector<unsigned> order = bvh_.build(mins, maxs);
+	primitives_.clear();
+
+	for (unsigned i : order) {
+		primitives_.push_back(primitives[i]);
+	}
+	built_area_ = bvh_.total_area();
+}
+
+void Composite::refit() {
+	if (primitives_.empty()) {
+		flatten();
+		return;
+	}
+	std::vector<glm::vec3> mins;
+	std::vector<glm::vec3> maxs;
+
+	for (auto const& primitive : primitives_) {
+		mins.push_back(primitive->min());
+		maxs.push_back(primitive->max());
+	}
+	bvh_.refit(mins, maxs);
+
+	if (bvh_.total_area() > REFIT_MAX_GROWTH * built_area_) {
+		flatten();
+		return;
+	}
+	Box local_bounds {bvh_.min(), bvh_.max()};
+	bounds_ = std::make_shared<Box>(local_bounds.min(world_transform_), local_bounds.max(world_transform_));
+}
+
+void Composite::collect_primitives(std::vector<std::shared_ptr<Shape>>& primitives, std::set<Shape const*>& visited) {
+	for (auto const& it : children_) {
+		auto composite = std::dynamic_pointer_cast<Composite>(it.second);
+
+		//octree cells and groups without own transformation are only containers, their contents are added directly
+		if (nullptr != composite && glm::mat4() == composite->world_transform_) {
+			composite->collect_primitives(primitives, visited);
+			continue;
+		}
+		//octree cells can share shapes that overlap several of them
+		if (!visited.insert(it.second.get()).second) {
+			continue;
+		}
+		if (nullptr != composite) {
+			composite->flatten();
+		}
+		primitives.push_back(it.second);
+	}
+}
+
 void Composite::transform(glm::mat4 const& transformation) {
 	Shape::transform(transformation);
 	build_octree();
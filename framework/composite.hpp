@@ -3,8 +3,10 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include "shape.hpp"
 #include "box.hpp"
+#include "bvh.hpp"
 
 class Composite : public Shape {
 public:
@@ -23,16 +25,40 @@ public:
 
 	std::ostream& print(std::ostream &os) const override;
 	HitPoint intersect(Ray const& ray) const override;
+	void intersect_packet(RayPacket const& packet, HitPoint* hits) const override;
 
 	void add_child(std::shared_ptr<Shape> shape);
 	unsigned int child_count();
 	std::shared_ptr<Shape> find_child(std::string const& name) const;
+	//shapes of the flattened hierarchy, empty if the octree is used
+	std::vector<std::shared_ptr<Shape>> const& primitives() const;
 
 	void build_octree();
 
+	/**
+	 * Replaces the nested composites and octree cells below this composite with one bounding volume hierarchy
+	 * over all shapes in its coordinate space. Transformed composites stay single entries of the hierarchy,
+	 * so only they and instances change the space of a ray.
+	 */
+	void flatten();
+
+	/**
+	 * Fits the hierarchy of a flattened composite to its shapes after they were moved, for example between the frames
+	 * of an animation. It is only built again if refitting left its boxes so much bigger that rays take too long.
+	 */
+	void refit();
+
 private:
 	std::shared_ptr<Box> bounds_;
 	std::map<std::string, std::shared_ptr<Shape>> children_;
+	//shapes of the flattened hierarchy in the order of its leaves, empty if the octree is used
+	std::vector<std::shared_ptr<Shape>> primitives_;
+	Bvh bvh_;
+	//surface area of the hierarchy when it was built, which refitting compares its boxes with
+	float built_area_;
+	bool is_transformed_;
+
+	void collect_primitives(std::vector<std::shared_ptr<Shape>>& primitives, std::set<Shape const*>& visited);
 };
 
 #endif //RAYTRACER_COMPOSITE_H
@@ -0,0 +1,248 @@
+#include <cmath>
+#include <algorithm>
+#include "compressedMesh.hpp"
+
+#define EPSILON 0.001f
+#define QUANTIZATION_STEPS 65535.0f
+
+CompressedMesh::CompressedMesh(std::vector<MeshTriangle> const& triangles, std::string const& name) :
+		Shape(name, nullptr),
+		min_{},
+		max_{},
+		step_{} {
+
+	if (triangles.empty()) {
+		return;
+	}
+	min_ = triangles[0].v0;
+	max_ = triangles[0].v0;
+
+	for (MeshTriangle const& triangle : triangles) {
+		min_ = glm::min(min_, glm::min(triangle.v0, glm::min(triangle.v1, triangle.v2)));
+		max_ = glm::max(max_, glm::max(triangle.v0, glm::max(triangle.v1, triangle.v2)));
+	}
+	step_ = (max_ - min_) / QUANTIZATION_STEPS;
+	std::vector<PackedTriangle> packed;
+	packed.reserve(triangles.size());
+
+	for (MeshTriangle const& triangle : triangles) {
+		PackedTriangle p {};
+		glm::vec3 const* vertices[3] {&triangle.v0, &triangle.v1, &triangle.v2};
+		std::uint16_t* packed_vertices[3] {p.v0, p.v1, p.v2};
+
+		for (int i = 0; i < 3; ++i) {
+			for (int axis = 0; axis < 3; ++axis) {
+				packed_vertices[i][axis] = quantize((*vertices[i])[axis], min_[axis], max_[axis]);
+			}
+		}
+		encode_octahedral(triangle.n, p.n);
+		//collects the few different materials of the mesh so each triangle only stores an index
+		auto it = std::find(materials_.begin(), materials_.end(), triangle.material);
+		p.material = it - materials_.begin();
+
+		if (materials_.end() == it) {
+			materials_.push_back(triangle.material);
+		}
+		packed.push_back(p);
+	}
+	//builds the bvh around the decoded positions so it encloses exactly what gets intersected later
+	std::vector<glm::vec3> mins(packed.size());
+	std::vector<glm::vec3> maxs(packed.size());
+
+	for (unsigned i = 0; i < packed.size(); ++i) {
+		glm::vec3 v0 = decode_position(packed[i].v0);
+		glm::vec3 v1 = decode_position(packed[i].v1);
+		glm::vec3 v2 = decode_position(packed[i].v2);
+		mins[i] = glm::min(v0, glm::min(v1, v2));
+		maxs[i] = glm::max(v0, glm::max(v1, v2));
+	}
+	std::vector<unsigned> order = bvh_.build(mins, maxs);
+	triangles_.reserve(packed.size());
+
+	for (unsigned i : order) {
+		triangles_.push_back(packed[i]);
+	}
+}
+
+float CompressedMesh::area() const {
+	float area_sum = 0;
+
+	for (PackedTriangle const& triangle : triangles_) {
+		glm::vec3 v0 = decode_position(triangle.v0);
+		area_sum += glm::length(glm::cross(decode_position(triangle.v1) - v0, decode_position(triangle.v2) - v0)) / 2;
+	}
+	return area_sum;
+}
+
+float CompressedMesh::volume() const {
+	return 0;
+}
+
+glm::vec3 CompressedMesh::min(glm::mat4 const& transform) const {
+	glm::mat4 final_transform = transform * world_transform_;
+	glm::vec3 min = transform_vec(min_, final_transform);
+
+	for (int corner = 1; corner < 8; ++corner) {
+		glm::vec3 v {corner & 1 ? max_.x : min_.x, corner & 2 ? max_.y : min_.y, corner & 4 ? max_.z : min_.z};
+		min = glm::min(min, transform_vec(v, final_transform));
+	}
+	return min;
+}
+
+glm::vec3 CompressedMesh::max(glm::mat4 const& transform) const {
+	glm::mat4 final_transform = transform * world_transform_;
+	glm::vec3 max = transform_vec(min_, final_transform);
+
+	for (int corner = 1; corner < 8; ++corner) {
+		glm::vec3 v {corner & 1 ? max_.x : min_.x, corner & 2 ? max_.y : min_.y, corner & 4 ? max_.z : min_.z};
+		max = glm::max(max, transform_vec(v, final_transform));
+	}
+	return max;
+}
+
+std::ostream& CompressedMesh::print(std::ostream &os) const {
+	Shape::print(os);
+	return os << "\ntriangles: " << triangle_count() << "\nmin:" << min_ << "\nmax:" << max_ << std::endl;
+}
+
+//https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/moller-trumbore-ray-triangle-intersection
+HitPoint CompressedMesh::intersect(Ray const& ray) const {
+	Ray ray_inv = transform_ray(ray, world_transform_inv_);
+	float closest_t = std::numeric_limits<float>::infinity();
+	PackedTriangle const* closest_triangle = nullptr;
+
+	bvh_.traverse(ray_inv, closest_t, [&](unsigned offset, unsigned count) {
+		for (unsigned i = offset; i < offset + count; ++i) {
+			PackedTriangle const& triangle = triangles_[i];
+			glm::vec3 v0 = decode_position(triangle.v0);
+			glm::vec3 v0v1 = decode_position(triangle.v1) - v0;
+			glm::vec3 v0v2 = decode_position(triangle.v2) - v0;
+			glm::vec3 p_vec = glm::cross(ray_inv.direction, v0v2);
+			float det = glm::dot(v0v1, p_vec);
+
+			//skips triangles parallel to the ray
+			if (det < EPSILON && det > -EPSILON) {
+				continue;
+			}
+			float inv_det = 1 / det;
+			glm::vec3 t_vec = ray_inv.origin - v0;
+			float u = glm::dot(t_vec, p_vec) * inv_det;
+
+			if (u < 0 || u > 1) {
+				continue;
+			}
+			glm::vec3 q_vec = glm::cross(t_vec, v0v1);
+			float v = glm::dot(ray_inv.direction, q_vec) * inv_det;
+
+			if (v < 0 || u + v > 1) {
+				continue;
+			}
+			float t = glm::dot(v0v2, q_vec) * inv_det;
+
+			if (t >= EPSILON && t - EPSILON < closest_t) {
+				closest_t = t - EPSILON;
+				closest_triangle = &triangle;
+			}
+		}
+	});
+	if (nullptr == closest_triangle) {
+		return {};
+	}
+	glm::vec3 normal = transform_vec(decode_octahedral(closest_triangle->n), world_transform_, false);
+	return {true, closest_t, name_, materials_[closest_triangle->material], ray.point(closest_t), ray.direction, normal};
+}
+
+void CompressedMesh::intersect_packet(RayPacket const& packet, HitPoint* hits) const {
+	RayPacket packet_inv = transform_packet(packet, world_transform_inv_);
+	float closest_ts[PACKET_SIZE];
+	PackedTriangle const* closest_triangles[PACKET_SIZE];
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		closest_ts[i] = hits[i].does_intersect ? hits[i].distance : std::numeric_limits<float>::infinity();
+		closest_triangles[i] = nullptr;
+	}
+	bvh_.traverse_packet(packet_inv, closest_ts, [&](unsigned offset, unsigned count, unsigned active_mask) {
+		for (unsigned i = offset; i < offset + count; ++i) {
+			//decodes each triangle once for all rays of the packet
+			PackedTriangle const& triangle = triangles_[i];
+			glm::vec3 v0 = decode_position(triangle.v0);
+			glm::vec3 v0v1 = decode_position(triangle.v1) - v0;
+			glm::vec3 v0v2 = decode_position(triangle.v2) - v0;
+
+			for (unsigned r = 0; r < packet_inv.size; ++r) {
+				if (0 == (active_mask & packet_inv.active_mask & 1u << r)) {
+					continue;
+				}
+				Ray const& ray = packet_inv.rays[r];
+				glm::vec3 p_vec = glm::cross(ray.direction, v0v2);
+				float det = glm::dot(v0v1, p_vec);
+				float inv_det = 1 / det;
+				glm::vec3 t_vec = ray.origin - v0;
+				float u = glm::dot(t_vec, p_vec) * inv_det;
+				glm::vec3 q_vec = glm::cross(t_vec, v0v1);
+				float v = glm::dot(ray.direction, q_vec) * inv_det;
+				float t = glm::dot(v0v2, q_vec) * inv_det;
+
+				if ((det >= EPSILON || det <= -EPSILON) && u >= 0 && u <= 1 && v >= 0 && u + v <= 1 &&
+				    t >= EPSILON && t - EPSILON < closest_ts[r]) {
+					closest_ts[r] = t - EPSILON;
+					closest_triangles[r] = &triangle;
+				}
+			}
+		}
+	});
+	for (unsigned i = 0; i < packet.size; ++i) {
+		if (nullptr == closest_triangles[i]) {
+			continue;
+		}
+		glm::vec3 normal = transform_vec(decode_octahedral(closest_triangles[i]->n), world_transform_, false);
+		hits[i] = {true, closest_ts[i], name_, materials_[closest_triangles[i]->material], packet.rays[i].point(closest_ts[i]), packet.rays[i].direction, normal};
+	}
+}
+
+unsigned CompressedMesh::triangle_count() const {
+	return triangles_.size();
+}
+
+std::size_t CompressedMesh::memory_size() const {
+	return sizeof(CompressedMesh) +
+	       triangles_.capacity() * sizeof(PackedTriangle) +
+	       materials_.capacity() * sizeof(std::shared_ptr<Material>) +
+	       bvh_.memory_size();
+}
+
+glm::vec3 CompressedMesh::decode_position(std::uint16_t const* quantized) const {
+	return min_ + glm::vec3 {quantized[0], quantized[1], quantized[2]} * step_;
+}
+
+std::uint16_t quantize(float value, float min, float max) {
+	if (max <= min) {
+		return 0;
+	}
+	return (std::uint16_t) std::lround((value - min) / (max - min) * QUANTIZATION_STEPS);
+}
+
+//https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+void encode_octahedral(glm::vec3 const& n, std::uint16_t* encoded) {
+	glm::vec2 p = glm::vec2 {n.x, n.y} / (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+
+	//folds the lower hemisphere over the diagonals of the octahedron
+	if (n.z < 0) {
+		p = glm::vec2 {
+				(1 - std::fabs(p.y)) * (p.x >= 0 ? 1 : -1),
+				(1 - std::fabs(p.x)) * (p.y >= 0 ? 1 : -1)};
+	}
+	encoded[0] = quantize(p.x, -1, 1);
+	encoded[1] = quantize(p.y, -1, 1);
+}
+
+glm::vec3 decode_octahedral(std::uint16_t const* encoded) {
+	glm::vec2 p = glm::vec2 {encoded[0], encoded[1]} * (2 / QUANTIZATION_STEPS) - 1.0f;
+	glm::vec3 n {p.x, p.y, 1 - std::fabs(p.x) - std::fabs(p.y)};
+
+	if (n.z < 0) {
+		n.x = (1 - std::fabs(p.y)) * (p.x >= 0 ? 1 : -1);
+		n.y = (1 - std::fabs(p.x)) * (p.y >= 0 ? 1 : -1);
+	}
+	return glm::normalize(n);
+}
@@ -0,0 +1,56 @@
+#ifndef RAYTRACER_COMPRESSEDMESH_HPP
+#define RAYTRACER_COMPRESSEDMESH_HPP
+
+#include <vector>
+#include <cstdint>
+#include "shape.hpp"
+#include "meshTriangle.hpp"
+#include "bvh.hpp"
+
+struct PackedTriangle {
+	//vertex positions quantized to 16 bit steps within the bounds of the mesh
+	std::uint16_t v0[3];
+	std::uint16_t v1[3];
+	std::uint16_t v2[3];
+	//face normal in octahedral encoding
+	std::uint16_t n[2];
+	std::uint16_t material;
+};
+
+/**
+ * Triangle mesh that stores 24 bytes per triangle instead of a Triangle shape for each face.
+ * Positions and normals are only decoded while intersecting the leaves of the bvh.
+ */
+class CompressedMesh : public Shape {
+public:
+	CompressedMesh(std::vector<MeshTriangle> const& triangles, std::string const& name = "mesh");
+
+	float area() const override;
+	float volume() const override;
+	glm::vec3 min(glm::mat4 const& transform = glm::mat4()) const override;
+	glm::vec3 max(glm::mat4 const& transform = glm::mat4()) const override;
+
+	std::ostream& print(std::ostream &os) const override;
+	HitPoint intersect(Ray const& ray) const override;
+	void intersect_packet(RayPacket const& packet, HitPoint* hits) const override;
+
+	unsigned triangle_count() const;
+	std::size_t memory_size() const;
+
+private:
+	glm::vec3 min_;
+	glm::vec3 max_;
+	//size of one quantization step on each axis
+	glm::vec3 step_;
+	std::vector<PackedTriangle> triangles_;
+	std::vector<std::shared_ptr<Material>> materials_;
+	Bvh bvh_;
+
+	glm::vec3 decode_position(std::uint16_t const* quantized) const;
+};
+
+std::uint16_t quantize(float value, float min, float max);
+void encode_octahedral(glm::vec3 const& n, std::uint16_t* encoded);
+glm::vec3 decode_octahedral(std::uint16_t const* encoded);
+
+#endif //RAYTRACER_COMPRESSEDMESH_HPP
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include "denoiser.hpp"
+#include "threadPool.hpp"
+
+//albedo below which a color channel is filtered as it is, dividing by it would blow up its noise
+#define MIN_ALBEDO 0.01f
+
+//weights of the B3 spline the filter blurs with
+static float const KERNEL[] {1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16};
+
+//approximates exp(-x) without a call, so the loops over the taps stay free of branches and calls and can be vectorized
+inline float falloff(float x) {
+	float base = 1 + x * 0.125f;
+	base *= base;
+	base *= base;
+	base *= base;
+	return 1 / base;
+}
+
+//one array per channel, so the loops over a row read consecutive floats
+struct Planes {
+	std::vector<float> r;
+	std::vector<float> g;
+	std::vector<float> b;
+
+	explicit Planes(unsigned size) :
+		r(size), g(size), b(size) {}
+};
+
+void denoise(std::vector<Color>& colors, std::vector<GuideSample> const& guides, unsigned width, unsigned height,
+             DenoiseOptions const& options) {
+	unsigned size = width * height;
+
+	if (0 == size || guides.size() != size || colors.size() != size) {
+		return;
+	}
+	Planes current {size};
+	Planes filtered {size};
+	Planes tone_mapped {size};
+	Planes albedos {size};
+	Planes normals {size};
+	std::vector<float> depths(size);
+
+	//divides the colors by the albedo, so only the lighting gets blurred
+	for (unsigned i = 0; i < size; ++i) {
+		GuideSample const& guide = guides[i];
+		albedos.r[i] = guide.albedo.r < MIN_ALBEDO ? 1 : guide.albedo.r;
+		albedos.g[i] = guide.albedo.g < MIN_ALBEDO ? 1 : guide.albedo.g;
+		albedos.b[i] = guide.albedo.b < MIN_ALBEDO ? 1 : guide.albedo.b;
+		current.r[i] = colors[i].r / albedos.r[i];
+		current.g[i] = colors[i].g / albedos.g[i];
+		current.b[i] = colors[i].b / albedos.b[i];
+		normals.r[i] = guide.normal.x;
+		normals.g[i] = guide.normal.y;
+		normals.b[i] = guide.normal.z;
+		depths[i] = guide.depth;
+	}
+	ThreadPool& pool = ThreadPool::global();
+	float color_sigma = options.color_sigma;
+
+	for (unsigned iteration = 0; iteration < options.iterations; ++iteration) {
+		int step = 1 << iteration;
+		float color_factor = 1 / (color_sigma * color_sigma);
+
+		//compares colors after tone mapping, so bright and dark parts of the image are blurred alike
+		for (unsigned i = 0; i < size; ++i) {
+			tone_mapped.r[i] = current.r[i] / (current.r[i] + 1);
+			tone_mapped.g[i] = current.g[i] / (current.g[i] + 1);
+			tone_mapped.b[i] = current.b[i] / (current.b[i] + 1);
+		}
+		pool.parallel_for(0, height, 4, [&](unsigned y) {
+			std::vector<float> sum_r(width, 0);
+			std::vector<float> sum_g(width, 0);
+			std::vector<float> sum_b(width, 0);
+			std::vector<float> sum_weights(width, 0);
+			unsigned row = y * width;
+
+			for (int dy = -2; dy <= 2; ++dy) {
+				int tap_y = (int) y + dy * step;
+
+				if (tap_y < 0 || tap_y >= (int) height) {
+					continue;
+				}
+				for (int dx = -2; dx <= 2; ++dx) {
+					int offset = dx * step;
+					//taps outside of the image are left out instead of clamped, which keeps the rows contiguous
+					int min_x = std::max(0, -offset);
+					int max_x = std::min((int) width, (int) width - offset);
+					float kernel = KERNEL[dy + 2] * KERNEL[dx + 2];
+					unsigned tap_row = tap_y * width + offset;
+
+					for (int x = min_x; x < max_x; ++x) {
+						unsigned p = row + x;
+						unsigned q = tap_row + x;
+						float dr = tone_mapped.r[p] - tone_mapped.r[q];
+						float dg = tone_mapped.g[p] - tone_mapped.g[q];
+						float db = tone_mapped.b[p] - tone_mapped.b[q];
+						float cos_normals = normals.r[p] * normals.r[q] + normals.g[p] * normals.g[q] + normals.b[p] * normals.b[q];
+						float depth_difference = std::abs(depths[p] - depths[q]) / (options.depth_sigma * step * depths[p] + 1e-6f);
+						float weight = kernel * falloff(
+								(dr * dr + dg * dg + db * db) * color_factor +
+								options.normal_power * std::max(0.0f, 1 - cos_normals) +
+								depth_difference);
+
+						sum_r[x] += weight * current.r[q];
+						sum_g[x] += weight * current.g[q];
+						sum_b[x] += weight * current.b[q];
+						sum_weights[x] += weight;
+					}
+				}
+			}
+			for (unsigned x = 0; x < width; ++x) {
+				filtered.r[row + x] = sum_r[x] / sum_weights[x];
+				filtered.g[row + x] = sum_g[x] / sum_weights[x];
+				filtered.b[row + x] = sum_b[x] / sum_weights[x];
+			}
+		});
+		std::swap(current, filtered);
+		//lets later passes with wider taps only blur colors that are already similar
+		color_sigma *= 0.5f;
+	}
+	for (unsigned i = 0; i < size; ++i) {
+		colors[i] = {current.r[i] * albedos.r[i], current.g[i] * albedos.g[i], current.b[i] * albedos.b[i]};
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef RAYTRACER_DENOISER_HPP
+#define RAYTRACER_DENOISER_HPP
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "color.hpp"
+
+//surface seen through a pixel, averaged over its samples, that tells the denoiser where the edges of the image are
+struct GuideSample {
+	//diffuse color of the surface, the lighting is filtered without it so textures and colored objects stay sharp
+	Color albedo {};
+	//zero for pixels that do not see any surface
+	glm::vec3 normal {};
+	float depth = 0;
+};
+
+struct DenoiseOptions {
+	//passes of the filter, each one reaches twice as far as the previous one
+	unsigned iterations = 5;
+	//difference of tone mapped colors that still gets blurred in the first pass, later passes halve it
+	float color_sigma = 1.5f;
+	//exponent of the cosine between normals, higher values blur less across bends
+	float normal_power = 64;
+	//relative difference of depths per pixel step that still gets blurred
+	float depth_sigma = 0.02f;
+};
+
+/**
+ * Edge-avoiding à-trous wavelet filter (Dammertz et al. 2010) that blurs the noise of few samples per pixel.
+ * Each pass blurs with a 5x5 B3 spline whose taps spread further apart, weighted down
+ * where the colors, normals or depths of the pixels differ.
+ * The rows of each pass are filtered in parallel by the global thread pool.
+ * @param colors colors of the image before tone mapping, row by row, that are replaced with the filtered ones
+ * @param guides surfaces of the pixels in the same order as the colors
+ */
+void denoise(std::vector<Color>& colors, std::vector<GuideSample> const& guides, unsigned width, unsigned height,
+             DenoiseOptions const& options = {});
+
+#endif
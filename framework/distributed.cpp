@@ -0,0 +1,320 @@
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "distributed.hpp"
+
+//milliseconds the coordinator waits for results before it looks for stragglers again
+#define POLL_INTERVAL 50
+
+//tile index and rectangle sent to a worker, the workers run on the same machine so the values are sent in its byte order
+struct TileJob {
+	uint32_t tile;
+	uint32_t min_x;
+	uint32_t min_y;
+	uint32_t max_x;
+	uint32_t max_y;
+};
+
+struct WorkerState {
+	//number of the worker in the options, which stays the same if other workers could not be started
+	unsigned index = 0;
+	pid_t pid = -1;
+	int socket = -1;
+	//tile the worker is rendering, -1 while it is idle
+	int tile = -1;
+	std::chrono::steady_clock::time_point started;
+	bool is_lost = false;
+};
+
+//sends without raising SIGPIPE when the other side is gone
+bool send_all(int socket, void const* data, std::size_t size) {
+	char const* bytes = static_cast<char const*>(data);
+
+	while (size > 0) {
+		ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+
+		if (sent < 0 && EINTR == errno) {
+			continue;
+		}
+		if (sent <= 0) {
+			return false;
+		}
+		bytes += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+bool receive_all(int socket, void* data, std::size_t size) {
+	char* bytes = static_cast<char*>(data);
+
+	while (size > 0) {
+		ssize_t received = recv(socket, bytes, size, 0);
+
+		if (received < 0 && EINTR == errno) {
+			continue;
+		}
+		if (received <= 0) {
+			return false;
+		}
+		bytes += received;
+		size -= received;
+	}
+	return true;
+}
+
+unsigned rect_size(PixelRect const& rect) {
+	return (rect.max_x - rect.min_x) * (rect.max_y - rect.min_y);
+}
+
+void run_worker(Renderer& renderer, Scene const& scene, int socket) {
+	TileJob job {};
+	std::vector<float> channels;
+
+	while (receive_all(socket, &job, sizeof(job))) {
+		PixelRect rect {job.min_x, job.min_y, job.max_x, job.max_y};
+		renderer.render_rect(scene, rect);
+		std::vector<Color> const& colors = renderer.color_buffer();
+		channels.clear();
+
+		for (unsigned y = rect.min_y; y < rect.max_y; ++y) {
+			for (unsigned x = rect.min_x; x < rect.max_x; ++x) {
+				Color const& color = colors[y * renderer.width() + x];
+				channels.insert(channels.end(), {color.r, color.g, color.b});
+			}
+		}
+		if (!send_all(socket, &job.tile, sizeof(job.tile)) ||
+		    !send_all(socket, channels.data(), channels.size() * sizeof(float))) {
+			return;
+		}
+	}
+}
+
+//closes the connection and stops the process of a worker that is not needed anymore
+void stop_worker(WorkerState& worker, bool is_killed) {
+	if (worker.socket >= 0) {
+		close(worker.socket);
+		worker.socket = -1;
+	}
+	//a worker still busy with a tile would only notice the closed connection after finishing it
+	if (is_killed) {
+		kill(worker.pid, SIGKILL);
+	}
+	waitpid(worker.pid, nullptr, 0);
+}
+
+std::vector<WorkerState> start_workers(Renderer& renderer, Scene const& scene, DistributedOptions const& options) {
+	unsigned core_count = std::max(1u, std::thread::hardware_concurrency());
+	unsigned thread_count = 0 == options.threads_per_worker ?
+			std::max(1u, core_count / std::max(1u, options.worker_count)) : options.threads_per_worker;
+	std::vector<WorkerState> workers;
+	//buffered output would be printed again by every worker
+	std::cout.flush();
+	std::cerr.flush();
+
+	for (unsigned i = 0; i < options.worker_count; ++i) {
+		int sockets[2];
+
+		if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) {
+			std::cerr << "could not connect worker " << i << std::endl;
+			continue;
+		}
+		pid_t pid = fork();
+
+		if (0 == pid) {
+			//the worker only keeps its own end, so it sees the coordinator closing it
+			close(sockets[0]);
+			for (WorkerState const& worker : workers) {
+				close(worker.socket);
+			}
+			ThreadPool::restart_global_after_fork(PoolOptions {thread_count});
+			run_worker(renderer, scene, sockets[1]);
+			//skips the destructors of the objects copied from the coordinator
+			_exit(0);
+		}
+		close(sockets[1]);
+
+		if (pid < 0) {
+			std::cerr << "could not start worker " << i << std::endl;
+			close(sockets[0]);
+			continue;
+		}
+		WorkerState worker;
+		worker.index = i;
+		worker.pid = pid;
+		worker.socket = sockets[0];
+		workers.push_back(worker);
+	}
+	return workers;
+}
+
+DistributedStats render_distributed(Renderer& renderer, Scene const& scene, DistributedOptions const& options) {
+	auto start = std::chrono::steady_clock::now();
+	unsigned tile_size = std::max(1u, options.tile_size);
+	std::vector<PixelRect> rects;
+
+	for (unsigned y = 0; y < renderer.height(); y += tile_size) {
+		for (unsigned x = 0; x < renderer.width(); x += tile_size) {
+			rects.push_back({x, y, std::min(x + tile_size, renderer.width()), std::min(y + tile_size, renderer.height())});
+		}
+	}
+	DistributedStats stats;
+	stats.tile_count = rects.size();
+	stats.worker_tiles.assign(options.worker_count, 0);
+	std::vector<WorkerState> workers = start_workers(renderer, scene, options);
+
+	std::deque<unsigned> queued_tiles;
+	for (unsigned i = 0; i < rects.size(); ++i) {
+		queued_tiles.push_back(i);
+	}
+	std::vector<bool> is_finished(rects.size(), false);
+	//workers rendering each tile at the moment
+	std::vector<unsigned> copies(rects.size(), 0);
+	unsigned finished_count = 0;
+	//seconds per pixel of the finished tiles, which tells how long a tile of any size should take
+	double finished_seconds = 0;
+	double finished_pixels = 0;
+	std::vector<float> channels;
+
+	auto lose_worker = [&](WorkerState& worker) {
+		if (worker.tile >= 0 && 0 == --copies[worker.tile] && !is_finished[worker.tile]) {
+			queued_tiles.push_front(worker.tile);
+			++stats.rescheduled_tiles;
+		}
+		worker.tile = -1;
+		worker.is_lost = true;
+		++stats.lost_workers;
+		stop_worker(worker, true);
+	};
+	//picks the tile that runs longest compared to the time it should take, if it is late enough to be rendered twice
+	auto find_straggler = [&]() {
+		int straggler = -1;
+		double max_delay = options.straggler_factor;
+		auto now = std::chrono::steady_clock::now();
+
+		for (WorkerState const& worker : workers) {
+			if (worker.is_lost || worker.tile < 0 || 1 != copies[worker.tile] || 0 == finished_pixels) {
+				continue;
+			}
+			double expected_seconds = finished_seconds / finished_pixels * rect_size(rects[worker.tile]);
+			double delay = std::chrono::duration<double>(now - worker.started).count() / expected_seconds;
+
+			if (delay > max_delay) {
+				max_delay = delay;
+				straggler = worker.tile;
+			}
+		}
+		return straggler;
+	};
+
+	while (finished_count < rects.size()) {
+		for (WorkerState& worker : workers) {
+			if (worker.is_lost || worker.tile >= 0) {
+				continue;
+			}
+			while (!queued_tiles.empty() && is_finished[queued_tiles.front()]) {
+				queued_tiles.pop_front();
+			}
+			int tile = -1;
+
+			if (!queued_tiles.empty()) {
+				tile = queued_tiles.front();
+				queued_tiles.pop_front();
+			} else {
+				tile = find_straggler();
+
+				if (tile < 0) {
+					break;
+				}
+				++stats.rescheduled_tiles;
+			}
+			PixelRect const& rect = rects[tile];
+			TileJob job {(uint32_t) tile, rect.min_x, rect.min_y, rect.max_x, rect.max_y};
+			worker.tile = tile;
+			worker.started = std::chrono::steady_clock::now();
+			++copies[tile];
+
+			if (!send_all(worker.socket, &job, sizeof(job))) {
+				lose_worker(worker);
+			}
+		}
+		std::vector<pollfd> busy;
+		std::vector<WorkerState*> busy_workers;
+
+		for (WorkerState& worker : workers) {
+			if (!worker.is_lost && worker.tile >= 0) {
+				busy.push_back({worker.socket, POLLIN, 0});
+				busy_workers.push_back(&worker);
+			}
+		}
+		if (busy.empty()) {
+			break;
+		}
+		if (poll(busy.data(), busy.size(), POLL_INTERVAL) < 0 && EINTR != errno) {
+			break;
+		}
+		for (unsigned i = 0; i < busy.size(); ++i) {
+			if (0 == busy[i].revents) {
+				continue;
+			}
+			WorkerState& worker = *busy_workers[i];
+			uint32_t tile;
+
+			if (!receive_all(worker.socket, &tile, sizeof(tile)) || tile != (uint32_t) worker.tile) {
+				lose_worker(worker);
+				continue;
+			}
+			PixelRect const& rect = rects[tile];
+			channels.resize(3 * rect_size(rect));
+
+			if (!receive_all(worker.socket, channels.data(), channels.size() * sizeof(float))) {
+				lose_worker(worker);
+				continue;
+			}
+			--copies[tile];
+			worker.tile = -1;
+
+			//the pixels of a tile rendered twice are the same, the second result is dropped
+			if (is_finished[tile]) {
+				continue;
+			}
+			unsigned channel = 0;
+
+			for (unsigned y = rect.min_y; y < rect.max_y; ++y) {
+				for (unsigned x = rect.min_x; x < rect.max_x; ++x) {
+					Pixel pixel {x, y};
+					pixel.color = {channels[channel], channels[channel + 1], channels[channel + 2]};
+					renderer.write(pixel);
+					channel += 3;
+				}
+			}
+			is_finished[tile] = true;
+			++finished_count;
+			++stats.worker_tiles[worker.index];
+			finished_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - worker.started).count();
+			finished_pixels += rect_size(rect);
+		}
+	}
+	for (WorkerState& worker : workers) {
+		if (!worker.is_lost) {
+			stop_worker(worker, worker.tile >= 0);
+		}
+	}
+	//renders the tiles no worker could finish
+	for (unsigned i = 0; i < rects.size(); ++i) {
+		if (!is_finished[i]) {
+			renderer.render_rect(scene, rects[i]);
+		}
+	}
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << stats.seconds << "s rendering on " << workers.size() << " workers\n";
+	renderer.save();
+	return stats;
+}
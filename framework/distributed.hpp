@@ -0,0 +1,45 @@
+#ifndef RAYTRACER_DISTRIBUTED_HPP
+#define RAYTRACER_DISTRIBUTED_HPP
+
+#include <vector>
+#include "renderer.hpp"
+
+struct DistributedOptions {
+	//amount of worker processes
+	unsigned worker_count = 2;
+	//threads of each worker, 0 splits the hardware threads evenly between the workers
+	unsigned threads_per_worker = 0;
+	//width and height of the tiles sent to the workers, bigger than the tiles of the threads so messages stay rare
+	unsigned tile_size = 64;
+	//a tile running this many times longer than the finished tiles took on average is sent to an idle worker again
+	float straggler_factor = 3;
+};
+
+struct DistributedStats {
+	unsigned tile_count = 0;
+	//tiles sent to a second worker because the first one took too long or was lost
+	unsigned rescheduled_tiles = 0;
+	//workers that closed their connection before the render was complete
+	unsigned lost_workers = 0;
+	//tiles rendered by each worker whose pixels ended up in the image
+	std::vector<unsigned> worker_tiles;
+	double seconds = 0;
+};
+
+/**
+ * Renders the image with worker processes forked from this one after the scene was loaded, so every worker starts with
+ * a copy of the scene and the renderer settings. The coordinator sends the tiles one at a time over a socket pair
+ * and writes the returned pixels into the image of the renderer, which is saved at the end.
+ * Once no tile is left to hand out, idle workers take over the tiles that run for too long, the first result wins.
+ * Tiles of lost workers are sent to the others, the coordinator renders what is left if all of them are lost.
+ * Only available on POSIX systems. The pixels are the same as those of render_rect for the whole image.
+ */
+DistributedStats render_distributed(Renderer& renderer, Scene const& scene, DistributedOptions const& options = {});
+
+/**
+ * Renders the tiles received over the connected stream socket and sends back their pixels,
+ * until the coordinator closes the connection.
+ */
+void run_worker(Renderer& renderer, Scene const& scene, int socket);
+
+#endif
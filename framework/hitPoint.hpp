@@ -13,5 +13,7 @@ struct HitPoint {
 	glm::vec3 position {};
 	glm::vec3 ray_direction {};
 	glm::vec3 surface_normal {};
+	//width of the ray cone at the hit point, or the width a level of detail was chosen with
+	float footprint = 0.0f;
 };
 #endif
@@ -0,0 +1,80 @@
+#include <cmath>
+#include <limits>
+#include "instance.hpp"
+
+Instance::Instance(std::shared_ptr<Shape const> shape, std::string const& name, std::shared_ptr<Material> material) :
+		Shape(name, material),
+		shape_{shape} {}
+
+float Instance::area() const {
+	return shape_->area();
+}
+
+float Instance::volume() const {
+	return shape_->volume();
+}
+
+glm::vec3 Instance::min(glm::mat4 const& transform) const {
+	return shape_->min(transform * world_transform_);
+}
+
+glm::vec3 Instance::max(glm::mat4 const& transform) const {
+	return shape_->max(transform * world_transform_);
+}
+
+std::ostream& Instance::print(std::ostream &os) const {
+	Shape::print(os);
+	return os << "\ninstance of: " << shape_->get_name() << std::endl;
+}
+
+HitPoint Instance::intersect(Ray const& ray) const {
+	Ray ray_inv = transform_ray(ray, world_transform_inv_);
+	ray_inv.cone_width *= cone_scale();
+	HitPoint hit = shape_->intersect(ray_inv);
+
+	if (hit.does_intersect) {
+		to_instance_space(hit, ray);
+	}
+	return hit;
+}
+
+void Instance::intersect_packet(RayPacket const& packet, HitPoint* hits) const {
+	RayPacket packet_inv = transform_packet(packet, world_transform_inv_);
+	float previous_ts[PACKET_SIZE];
+	float scale = cone_scale();
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		packet_inv.rays[i].cone_width *= scale;
+		previous_ts[i] = hits[i].does_intersect ? hits[i].distance : std::numeric_limits<float>::infinity();
+	}
+	//distances along the rays are the same in both spaces, so the shared shape can replace the hits in place
+	shape_->intersect_packet(packet_inv, hits);
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		if (hits[i].does_intersect && hits[i].distance != previous_ts[i]) {
+			to_instance_space(hits[i], packet.rays[i]);
+		}
+	}
+}
+
+//scales the ray cone into object space, the spread is an angle and stays the same
+float Instance::cone_scale() const {
+	return std::cbrt(std::fabs(glm::determinant(glm::mat3(world_transform_inv_))));
+}
+
+void Instance::to_instance_space(HitPoint& hit, Ray const& ray) const {
+	//the ray is not normalized in object space, so the distance along it stays the same in world space
+	hit.position = ray.point(hit.distance);
+	hit.ray_direction = ray.direction;
+	//normals are transformed with the inverse transpose to stay perpendicular under non uniform scaling
+	hit.surface_normal = glm::normalize(transform_vec(hit.surface_normal, glm::transpose(world_transform_inv_), false));
+	hit.footprint /= cone_scale();
+
+	if (nullptr != material_) {
+		hit.hit_material = material_;
+	}
+}
+
+std::shared_ptr<Shape const> Instance::shape() const {
+	return shape_;
+}
@@ -0,0 +1,33 @@
+#ifndef RAYTRACER_INSTANCE_HPP
+#define RAYTRACER_INSTANCE_HPP
+
+#include "shape.hpp"
+
+/**
+ * Places a shared, immutable shape (e.g. a loaded .obj mesh) in the scene with an own transformation.
+ * If a material is given it overrides the materials of the shared shape.
+ */
+class Instance : public Shape {
+public:
+	Instance(std::shared_ptr<Shape const> shape, std::string const& name, std::shared_ptr<Material> material = nullptr);
+
+	float area() const override;
+	float volume() const override;
+	glm::vec3 min(glm::mat4 const& transform = glm::mat4()) const override;
+	glm::vec3 max(glm::mat4 const& transform = glm::mat4()) const override;
+
+	std::ostream& print(std::ostream &os) const override;
+	HitPoint intersect(Ray const& ray) const override;
+	void intersect_packet(RayPacket const& packet, HitPoint* hits) const override;
+
+	std::shared_ptr<Shape const> shape() const;
+
+private:
+	std::shared_ptr<Shape const> shape_;
+
+	float cone_scale() const;
+	//moves a hit of the shared shape into the space of the instance
+	void to_instance_space(HitPoint& hit, Ray const& ray) const;
+};
+
+#endif //RAYTRACER_INSTANCE_HPP
@@ -0,0 +1,69 @@
+#include "lodMesh.hpp"
+#include "bvh.hpp"
+
+LodMesh::LodMesh(std::vector<std::shared_ptr<Shape>> const& levels, std::vector<float> const& edge_lengths, std::string const& name) :
+		Shape(name, nullptr),
+		levels_{levels},
+		edge_lengths_{edge_lengths},
+		min_{levels[0]->min()},
+		max_{levels[0]->max()} {}
+
+float LodMesh::area() const {
+	return levels_[0]->area();
+}
+
+float LodMesh::volume() const {
+	return levels_[0]->volume();
+}
+
+glm::vec3 LodMesh::min(glm::mat4 const& transform) const {
+	return levels_[0]->min(transform * world_transform_);
+}
+
+glm::vec3 LodMesh::max(glm::mat4 const& transform) const {
+	return levels_[0]->max(transform * world_transform_);
+}
+
+std::ostream& LodMesh::print(std::ostream &os) const {
+	Shape::print(os);
+	os << "\nlevels: " << level_count();
+
+	for (float edge_length : edge_lengths_) {
+		os << " " << edge_length;
+	}
+	return os << std::endl;
+}
+
+HitPoint LodMesh::intersect(Ray const& ray) const {
+	Ray ray_inv = transform_ray(ray, world_transform_inv_);
+	float footprint;
+	HitPoint hit = levels_[select_level(ray_inv, footprint)]->intersect(ray_inv);
+
+	if (hit.does_intersect) {
+		hit.position = ray.point(hit.distance);
+		hit.surface_normal = glm::normalize(transform_vec(hit.surface_normal, world_transform_, false));
+		//rays starting at the hit point select their level with the same footprint and don't hit a different surface
+		hit.footprint = footprint;
+	}
+	return hit;
+}
+
+unsigned LodMesh::level_count() const {
+	return levels_.size();
+}
+
+unsigned LodMesh::select_level(Ray const& ray, float& footprint) const {
+	float entry_t;
+	footprint = 0;
+
+	if (!intersect_bounds(min_, max_, ray.origin, 1.0f / ray.direction, std::numeric_limits<float>::infinity(), entry_t)) {
+		return 0;
+	}
+	footprint = ray.footprint(std::max(0.0f, entry_t));
+	unsigned level = 0;
+
+	while (level + 1 < levels_.size() && edge_lengths_[level + 1] <= footprint) {
+		++level;
+	}
+	return level;
+}
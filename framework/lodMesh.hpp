@@ -0,0 +1,37 @@
+#ifndef RAYTRACER_LODMESH_HPP
+#define RAYTRACER_LODMESH_HPP
+
+#include <vector>
+#include "shape.hpp"
+
+/**
+ * Mesh with several simplified versions of itself. Each ray only intersects the coarsest level
+ * whose triangle edges are still shorter than the ray footprint where the ray reaches the mesh.
+ */
+class LodMesh : public Shape {
+public:
+	/**
+	 * @param levels meshes from the most detailed to the coarsest
+	 * @param edge_lengths average triangle edge length of each level
+	 */
+	LodMesh(std::vector<std::shared_ptr<Shape>> const& levels, std::vector<float> const& edge_lengths, std::string const& name);
+
+	float area() const override;
+	float volume() const override;
+	glm::vec3 min(glm::mat4 const& transform = glm::mat4()) const override;
+	glm::vec3 max(glm::mat4 const& transform = glm::mat4()) const override;
+
+	std::ostream& print(std::ostream &os) const override;
+	HitPoint intersect(Ray const& ray) const override;
+
+	unsigned level_count() const;
+	unsigned select_level(Ray const& ray, float& footprint) const;
+
+private:
+	std::vector<std::shared_ptr<Shape>> levels_;
+	std::vector<float> edge_lengths_;
+	glm::vec3 min_;
+	glm::vec3 max_;
+};
+
+#endif //RAYTRACER_LODMESH_HPP
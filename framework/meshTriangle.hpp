@@ -0,0 +1,26 @@
+#ifndef RAYTRACER_MESHTRIANGLE_HPP
+#define RAYTRACER_MESHTRIANGLE_HPP
+
+#include <memory>
+#include <glm/glm.hpp>
+#include "material.hpp"
+
+//triangle as read from a mesh file before it is stored in the format chosen for the scene
+struct MeshTriangle {
+	glm::vec3 v0 {};
+	glm::vec3 v1 {};
+	glm::vec3 v2 {};
+	glm::vec3 n {};
+	std::shared_ptr<Material> material = nullptr;
+};
+
+//flat convex four sided face of a mesh file, kept whole for formats that can store quads
+struct MeshQuad {
+	glm::vec3 v0 {};
+	glm::vec3 v1 {};
+	glm::vec3 v2 {};
+	glm::vec3 v3 {};
+	glm::vec3 n {};
+	std::shared_ptr<Material> material = nullptr;
+};
+#endif
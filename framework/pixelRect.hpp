@@ -0,0 +1,12 @@
+#ifndef RAYTRACER_PIXELRECT_HPP
+#define RAYTRACER_PIXELRECT_HPP
+
+//rectangle of pixels from the min corner up to but not including the max corner
+struct PixelRect {
+	unsigned min_x = 0;
+	unsigned min_y = 0;
+	unsigned max_x = 0;
+	unsigned max_y = 0;
+};
+
+#endif
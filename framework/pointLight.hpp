@@ -9,5 +9,7 @@ struct PointLight {
 	glm::vec3 position = {};
 	float brightness = 1;
 	Color intensity = color * brightness;
+	//lights with a radius are spheres that path tracing can also hit, the light of all lights falls off with the squared distance
+	float radius = 0;
 };
 #endif
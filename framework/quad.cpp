@@ -0,0 +1,143 @@
+#include <cmath>
+#include "quad.hpp"
+
+#define EPSILON 0.001f
+//allowed distance of the fourth corner from the plane of the other three, relative to the longest edge
+#define FLATNESS_TOLERANCE 0.0001f
+
+Quad::Quad(
+		glm::vec3 const& v0,
+		glm::vec3 const& v1,
+		glm::vec3 const& v2,
+		glm::vec3 const& v3,
+		std::string const& name,
+		std::shared_ptr<Material> material) :
+		Quad(v0, v1, v2, v3, glm::normalize(glm::cross(v2 - v0, v3 - v1)), name, material) {}
+
+Quad::Quad(
+		glm::vec3 const& v0,
+		glm::vec3 const& v1,
+		glm::vec3 const& v2,
+		glm::vec3 const& v3,
+		glm::vec3 const& n,
+		std::string const& name,
+		std::shared_ptr<Material> material) :
+		Shape(name, material),
+		v0_{v0},
+		v1_{v1},
+		v2_{v2},
+		v3_{v3},
+		n_{n} {}
+
+float Quad::area() const {
+	//the cross product of the diagonals is twice the area of a flat quad
+	return glm::length(glm::cross(v2_ - v0_, v3_ - v1_)) / 2;
+}
+
+float Quad::volume() const {
+	return 0;
+}
+
+glm::vec3 Quad::min(glm::mat4 const& transform) const {
+	glm::mat4 final_transform = transform * world_transform_;
+	glm::vec3 min = glm::min(transform_vec(v0_, final_transform), transform_vec(v1_, final_transform));
+	min = glm::min(min, glm::min(transform_vec(v2_, final_transform), transform_vec(v3_, final_transform)));
+	return min;
+}
+
+glm::vec3 Quad::max(glm::mat4 const& transform) const {
+	glm::mat4 final_transform = transform * world_transform_;
+	glm::vec3 max = glm::max(transform_vec(v0_, final_transform), transform_vec(v1_, final_transform));
+	max = glm::max(max, glm::max(transform_vec(v2_, final_transform), transform_vec(v3_, final_transform)));
+	return max;
+}
+
+std::ostream &Quad::print(std::ostream &os) const {
+	Shape::print(os);
+	return os << "\nv0:" << v0_ << "\nv1:" << v1_ << "\nv2:" << v2_ << "\nv3:" << v3_ << "\nn:" << n_ << std::endl;
+}
+
+//Lagae and Dutré, An Efficient Ray-Quadrilateral Intersection Test
+HitPoint Quad::intersect(Ray const& ray) const {
+	Ray ray_inv = transform_ray(ray, world_transform_inv_);
+	//tests the edges meeting at v0 like möller trumbore does for the triangle v0 v1 v3
+	glm::vec3 v0v1 = v1_ - v0_;
+	glm::vec3 v0v3 = v3_ - v0_;
+	glm::vec3 p_vec = glm::cross(ray_inv.direction, v0v3);
+	float det = glm::dot(v0v1, p_vec);
+
+	//returns if the ray is parallel to the quad
+	if (det < EPSILON && det > -EPSILON) {
+		return {};
+	}
+	float inv_det = 1 / det;
+	glm::vec3 t_vec = ray_inv.origin - v0_;
+	float u = glm::dot(t_vec, p_vec) * inv_det;
+
+	if (u < 0) {
+		return {};
+	}
+	glm::vec3 q_vec = glm::cross(t_vec, v0v1);
+	float v = glm::dot(ray_inv.direction, q_vec) * inv_det;
+
+	if (v < 0) {
+		return {};
+	}
+	//hit points beyond the diagonal v1 v3 must instead lie between the edges meeting at v2
+	//which together with the edges at v0 encloses exactly the convex quad
+	if (u + v > 1) {
+		glm::vec3 v2v3 = v3_ - v2_;
+		glm::vec3 v2v1 = v1_ - v2_;
+		glm::vec3 p_vec2 = glm::cross(ray_inv.direction, v2v1);
+		float det2 = glm::dot(v2v3, p_vec2);
+
+		if (det2 < EPSILON && det2 > -EPSILON) {
+			return {};
+		}
+		glm::vec3 t_vec2 = ray_inv.origin - v2_;
+		float u2 = glm::dot(t_vec2, p_vec2) / det2;
+
+		if (u2 < 0) {
+			return {};
+		}
+		float v2 = glm::dot(ray_inv.direction, glm::cross(t_vec2, v2v3)) / det2;
+
+		if (v2 < 0) {
+			return {};
+		}
+	}
+	float t = glm::dot(v0v3, q_vec) * inv_det;
+
+	if (t < EPSILON) {
+		return {};
+	}
+	t -= EPSILON;
+	return {true, t, name_, material_, ray.point(t), ray.direction, transform_vec(n_, world_transform_, false)};
+}
+
+bool is_flat_convex_quad(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2, glm::vec3 const& v3) {
+	glm::vec3 corners[4] {v0, v1, v2, v3};
+	glm::vec3 normal = glm::cross(v2 - v0, v3 - v1);
+	float longest_edge = 0;
+
+	for (int i = 0; i < 4; ++i) {
+		longest_edge = std::fmax(longest_edge, glm::length(corners[(i + 1) % 4] - corners[i]));
+	}
+	if (0 == glm::length(normal) || 0 == longest_edge) {
+		return false;
+	}
+	normal = glm::normalize(normal);
+
+	for (int i = 0; i < 4; ++i) {
+		//every corner has to lie on the common plane and turn in the same direction around it
+		if (std::fabs(glm::dot(corners[i] - v0, normal)) > FLATNESS_TOLERANCE * longest_edge) {
+			return false;
+		}
+		glm::vec3 turn = glm::cross(corners[(i + 1) % 4] - corners[i], corners[(i + 2) % 4] - corners[(i + 1) % 4]);
+
+		if (glm::dot(turn, normal) <= 0) {
+			return false;
+		}
+	}
+	return true;
+}
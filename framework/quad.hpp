@@ -0,0 +1,47 @@
+#ifndef RAYTRACER_QUAD_HPP
+#define RAYTRACER_QUAD_HPP
+#include "shape.hpp"
+
+/**
+ * Flat convex quadrilateral with its corners in order around the edge.
+ * Intersecting it once is cheaper than intersecting the two triangles it could be split into.
+ */
+class Quad : public Shape {
+public:
+	Quad(
+			glm::vec3 const& v0,
+			glm::vec3 const& v1,
+			glm::vec3 const& v2,
+			glm::vec3 const& v3,
+			std::string const& name = "quad",
+			std::shared_ptr<Material> material = nullptr);
+
+	Quad(
+			glm::vec3 const& v0,
+			glm::vec3 const& v1,
+			glm::vec3 const& v2,
+			glm::vec3 const& v3,
+			glm::vec3 const& n,
+			std::string const& name = "quad",
+			std::shared_ptr<Material> material = nullptr);
+
+	float area() const override;
+	float volume() const override;
+	glm::vec3 min(glm::mat4 const& transform) const override;
+	glm::vec3 max(glm::mat4 const& transform) const override;
+
+	std::ostream& print (std::ostream &os) const override;
+	HitPoint intersect(Ray const& ray) const override;
+
+private:
+	glm::vec3 v0_;
+	glm::vec3 v1_;
+	glm::vec3 v2_;
+	glm::vec3 v3_;
+	glm::vec3 n_;
+};
+
+//checks if the four corners lie in one plane and form a convex outline, which is what the quad intersection requires
+bool is_flat_convex_quad(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2, glm::vec3 const& v3);
+
+#endif //RAYTRACER_QUAD_HPP
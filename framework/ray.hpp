@@ -1,4 +1,3 @@
-
 #ifndef RAYTRACER_RAY_HPP
 #define RAYTRACER_RAY_HPP
 
@@ -7,9 +6,18 @@
 struct Ray {
 	glm::vec3 origin = {0.0f, 0.0f, 0.0f};
 	glm::vec3 direction = {0.0f, 0.0f, -1.0f};
+	//width of the cone around the ray at its origin
+	float cone_width = 0.0f;
+	//growth of the cone width per unit of travelled distance
+	float cone_spread = 0.0f;
 
 	[[nodiscard]] glm::vec3 point(float distance) const {
 		return origin + direction * distance;
 	}
+
+	//width of the ray cone at a point of the ray, used to choose how detailed geometry there has to be
+	[[nodiscard]] float footprint(float distance) const {
+		return cone_width + cone_spread * distance * glm::length(direction);
+	}
 };
 #endif
@@ -0,0 +1,32 @@
+#ifndef RAYTRACER_RAYPACKET_HPP
+#define RAYTRACER_RAYPACKET_HPP
+
+#include "ray.hpp"
+
+//most rays traced together, enough for a 4x4 block of camera rays
+#define PACKET_SIZE 16
+
+/**
+ * Rays with similar directions that are traced through the scene together,
+ * so bounding volumes and triangles only have to be fetched once for all of them.
+ */
+struct RayPacket {
+	Ray rays[PACKET_SIZE];
+	unsigned size = 0;
+	//bit i is set if ray i still has to be intersected, shapes skip the other rays
+	unsigned active_mask = 0;
+	//true if all rays start at the same point, which lets whole packets be tested against a box at once
+	bool has_common_origin = true;
+
+	void add(Ray const& ray) {
+		has_common_origin = has_common_origin && (0 == size || ray.origin == rays[0].origin);
+		rays[size] = ray;
+		active_mask |= 1u << size;
+		++size;
+	}
+
+	bool is_active(unsigned i) const {
+		return 0 != (active_mask & 1u << i);
+	}
+};
+#endif
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include "rayQueue.hpp"
+
+//bits per axis of the grid that ray origins are sorted on
+#define ORIGIN_BITS 10
+
+//spreads the lower 10 bits of x out to every third bit
+uint32_t spread_bits(uint32_t x) {
+	x &= 0x3ff;
+	x = (x | x << 16) & 0x30000ff;
+	x = (x | x << 8) & 0x300f00f;
+	x = (x | x << 4) & 0x30c30c3;
+	x = (x | x << 2) & 0x9249249;
+	return x;
+}
+
+void RayQueue::sort() {
+	//the rays of a single packet are traced together in any order
+	if (size() <= PACKET_SIZE) {
+		return;
+	}
+	glm::vec3 min {std::numeric_limits<float>::infinity()};
+	glm::vec3 max {-std::numeric_limits<float>::infinity()};
+
+	for (glm::vec3 const& origin : origins) {
+		min = glm::min(min, origin);
+		max = glm::max(max, origin);
+	}
+	glm::vec3 extent = max - min;
+	glm::vec3 scale {};
+
+	for (int axis = 0; axis < 3; ++axis) {
+		scale[axis] = extent[axis] > 0 ? ((1 << ORIGIN_BITS) - 1) / extent[axis] : 0;
+	}
+	//the direction octant comes first, rays that head different ways share hardly any nodes anyway
+	std::vector<std::pair<uint64_t, unsigned>> keys(size());
+
+	for (unsigned i = 0; i < size(); ++i) {
+		glm::vec3 cell = (origins[i] - min) * scale;
+		uint64_t octant = (directions[i].x < 0) | (directions[i].y < 0) << 1 | (directions[i].z < 0) << 2;
+		uint32_t morton = spread_bits(cell.x) | spread_bits(cell.y) << 1 | spread_bits(cell.z) << 2;
+		keys[i] = {octant << 3 * ORIGIN_BITS | morton, i};
+	}
+	std::sort(keys.begin(), keys.end());
+	RayQueue sorted;
+	sorted.reserve(size());
+
+	for (auto const& key : keys) {
+		sorted.push(ray(key.second), weights[key.second], pixels[key.second], paths[key.second]);
+	}
+	*this = std::move(sorted);
+}
@@ -0,0 +1,113 @@
+#ifndef RAYTRACER_RAYQUEUE_HPP
+#define RAYTRACER_RAYQUEUE_HPP
+
+#include <vector>
+#include "color.hpp"
+#include "ray.hpp"
+#include "rayPacket.hpp"
+
+/**
+ * Rays of one bounce that wait for their closest hit, stored as one array per attribute,
+ * so each stage of the wavefront renderer only touches the attributes it needs.
+ */
+struct RayQueue {
+	std::vector<glm::vec3> origins;
+	std::vector<glm::vec3> directions;
+	std::vector<float> cone_widths;
+	std::vector<float> cone_spreads;
+	//share of the ray in the color of its pixel
+	std::vector<Color> weights;
+	//index of the pixel the ray contributes to
+	std::vector<unsigned> pixels;
+	//sample of the pixel for camera rays, the rays they spawn hash the number of their parent with the kind of bounce,
+	//so each ray of a pixel has its own number in every wave however many bounces it took
+	std::vector<unsigned> paths;
+
+	void push(Ray const& ray, Color const& weight, unsigned pixel, unsigned path) {
+		origins.push_back(ray.origin);
+		directions.push_back(ray.direction);
+		cone_widths.push_back(ray.cone_width);
+		cone_spreads.push_back(ray.cone_spread);
+		weights.push_back(weight);
+		pixels.push_back(pixel);
+		paths.push_back(path);
+	}
+
+	[[nodiscard]] Ray ray(unsigned i) const {
+		return Ray {origins[i], directions[i], cone_widths[i], cone_spreads[i]};
+	}
+
+	[[nodiscard]] unsigned size() const {
+		return origins.size();
+	}
+
+	[[nodiscard]] bool empty() const {
+		return origins.empty();
+	}
+
+	void reserve(unsigned capacity) {
+		origins.reserve(capacity);
+		directions.reserve(capacity);
+		cone_widths.reserve(capacity);
+		cone_spreads.reserve(capacity);
+		weights.reserve(capacity);
+		pixels.reserve(capacity);
+		paths.reserve(capacity);
+	}
+
+	/**
+	 * Reorders the rays by the octant of their direction and the Morton code of their origin,
+	 * so rays next to each other start close together, head the same way and take similar paths through a BVH.
+	 */
+	void sort();
+
+	void clear() {
+		origins.clear();
+		directions.clear();
+		cone_widths.clear();
+		cone_spreads.clear();
+		weights.clear();
+		pixels.clear();
+		paths.clear();
+	}
+};
+
+/**
+ * Rays towards lights that add the light they carry to their pixel if nothing blocks them.
+ */
+struct ShadowQueue {
+	std::vector<glm::vec3> origins;
+	std::vector<glm::vec3> directions;
+	std::vector<float> cone_widths;
+	//distance to the light, hits behind it do not block the light
+	std::vector<float> ranges;
+	std::vector<Color> contributions;
+	std::vector<unsigned> pixels;
+
+	void push(Ray const& ray, float range, Color const& contribution, unsigned pixel) {
+		origins.push_back(ray.origin);
+		directions.push_back(ray.direction);
+		cone_widths.push_back(ray.cone_width);
+		ranges.push_back(range);
+		contributions.push_back(contribution);
+		pixels.push_back(pixel);
+	}
+
+	[[nodiscard]] Ray ray(unsigned i) const {
+		return Ray {origins[i], directions[i], cone_widths[i]};
+	}
+
+	[[nodiscard]] unsigned size() const {
+		return origins.size();
+	}
+
+	void clear() {
+		origins.clear();
+		directions.clear();
+		cone_widths.clear();
+		ranges.clear();
+		contributions.clear();
+		pixels.clear();
+	}
+};
+#endif
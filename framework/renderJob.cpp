@@ -0,0 +1,81 @@
+#include "renderJob.hpp"
+
+RenderJob::RenderJob(RenderCallbacks callbacks) :
+	callbacks_{std::move(callbacks)},
+	is_cancelled_{false},
+	start_{std::chrono::steady_clock::now()},
+	finished_tiles_{0},
+	tile_count_{0},
+	finished_pixels_{0},
+	pixel_count_{0},
+	samples_per_pixel_{0} {}
+
+RenderJob::~RenderJob() {
+	wait();
+}
+
+void RenderJob::cancel() {
+	is_cancelled_ = true;
+}
+
+bool RenderJob::is_cancelled() const {
+	return is_cancelled_;
+}
+
+bool RenderJob::is_finished() const {
+	return !task_.valid() || std::future_status::ready == task_.wait_for(std::chrono::seconds(0));
+}
+
+void RenderJob::wait() {
+	if (task_.valid()) {
+		task_.wait();
+	}
+}
+
+RenderProgress RenderJob::progress() const {
+	std::lock_guard<std::mutex> lock {mutex_};
+	return progress_locked();
+}
+
+void RenderJob::start(std::vector<PixelRect> const& rects, unsigned samples_per_pixel) {
+	std::lock_guard<std::mutex> lock {mutex_};
+	start_ = std::chrono::steady_clock::now();
+	finished_tiles_ = 0;
+	tile_count_ = rects.size();
+	finished_pixels_ = 0;
+	pixel_count_ = 0;
+	samples_per_pixel_ = samples_per_pixel;
+
+	for (PixelRect const& rect : rects) {
+		pixel_count_ += (rect.max_x - rect.min_x) * (rect.max_y - rect.min_y);
+	}
+}
+
+void RenderJob::finish_tile(PixelRect const& rect) {
+	std::lock_guard<std::mutex> lock {mutex_};
+	++finished_tiles_;
+	finished_pixels_ += (rect.max_x - rect.min_x) * (rect.max_y - rect.min_y);
+
+	if (callbacks_.on_tile) {
+		callbacks_.on_tile(rect);
+	}
+	if (callbacks_.on_progress) {
+		callbacks_.on_progress(progress_locked());
+	}
+}
+
+RenderProgress RenderJob::progress_locked() const {
+	RenderProgress progress;
+	progress.finished_tiles = finished_tiles_;
+	progress.tile_count = tile_count_;
+	progress.rays = finished_pixels_ * samples_per_pixel_;
+	progress.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+	if (progress.elapsed_seconds > 0) {
+		progress.rays_per_second = progress.rays / progress.elapsed_seconds;
+	}
+	if (finished_pixels_ > 0) {
+		progress.remaining_seconds = progress.elapsed_seconds * (pixel_count_ - finished_pixels_) / finished_pixels_;
+	}
+	return progress;
+}
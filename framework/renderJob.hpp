@@ -0,0 +1,75 @@
+#ifndef RAYTRACER_RENDERJOB_HPP
+#define RAYTRACER_RENDERJOB_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+#include "pixelRect.hpp"
+
+struct RenderProgress {
+	unsigned finished_tiles = 0;
+	unsigned tile_count = 0;
+	//estimate of the camera rays traced so far, the finished pixels times the samples of the full anti aliasing grid,
+	//adaptive anti aliasing and reduced pixel patterns trace fewer, reflections and shadow rays are not counted
+	unsigned long long rays = 0;
+	double elapsed_seconds = 0;
+	double rays_per_second = 0;
+	//estimated from the share of pixels rendered so far, 0 until the first tile is finished
+	double remaining_seconds = 0;
+};
+
+/**
+ * Functions a render calls while it runs. They are called by the rendering threads, but never at the same time.
+ */
+struct RenderCallbacks {
+	//called with the progress after every finished tile
+	std::function<void(RenderProgress const&)> on_progress;
+	//called with every finished tile, whose pixels are in the color buffer already
+	std::function<void(PixelRect const&)> on_tile;
+};
+
+/**
+ * Handle of a render that runs in the background.
+ * The renderer and the scene have to outlive the job, destroying the job waits until the render is finished.
+ */
+class RenderJob {
+public:
+	explicit RenderJob(RenderCallbacks callbacks = {});
+	//waits until the render is finished, the rendering thread still reports its tiles to the job until then
+	~RenderJob();
+	RenderJob(RenderJob const&) = delete;
+	RenderJob& operator=(RenderJob const&) = delete;
+
+	//lets the render skip all tiles it has not started yet, the finished ones are still saved
+	void cancel();
+	bool is_cancelled() const;
+	bool is_finished() const;
+	//blocks until the render is finished or cancelled
+	void wait();
+	RenderProgress progress() const;
+
+private:
+	friend class Renderer;
+
+	RenderCallbacks callbacks_;
+	std::atomic<bool> is_cancelled_;
+	//guards the progress and lets the callbacks run one at a time
+	mutable std::mutex mutex_;
+	std::chrono::steady_clock::time_point start_;
+	unsigned finished_tiles_;
+	unsigned tile_count_;
+	unsigned long long finished_pixels_;
+	unsigned long long pixel_count_;
+	unsigned samples_per_pixel_;
+	//declared last, so it is destroyed first and the members the render uses outlive it
+	std::future<void> task_;
+
+	void start(std::vector<PixelRect> const& rects, unsigned samples_per_pixel);
+	void finish_tile(PixelRect const& rect);
+	RenderProgress progress_locked() const;
+};
+
+#endif
@@ -8,88 +8,1218 @@
 // -----------------------------------------------------------------------------
 
 #include <chrono>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
 #include "renderer.hpp"
 
 #define EPSILON 0.001f
 
-Renderer::Renderer(unsigned w, unsigned h, std::string const& file, unsigned aa_steps, unsigned max_ray_bounces) :
+//interleaves the bits of x and y, so sorting by the code keeps neighboring tiles close to each other
+unsigned morton_code(unsigned x, unsigned y) {
+	unsigned code = 0;
+
+	for (unsigned bit = 0; bit < 16; ++bit) {
+		code |= ((x >> bit) & 1u) << (2 * bit) | ((y >> bit) & 1u) << (2 * bit + 1);
+	}
+	return code;
+}
+
+Renderer::Renderer(unsigned w, unsigned h, std::string const& file, unsigned aa_steps, unsigned max_ray_bounces,
+                   unsigned tile_size, RenderMode mode) :
 		width_(w),
 		height_(h),
 		color_buffer_(w * h, Color{0.0, 0.0, 0.0}),
 		filename_(file), ppm_(width_, height_),
+		sample_count_(0),
+		noise_(0),
 		aa_steps_(aa_steps),
-		max_ray_bounces_(max_ray_bounces) {}
+		max_ray_bounces_(max_ray_bounces),
+		cone_spread_(0),
+		tile_size_(std::max(1u, tile_size)),
+		sampler_(std::make_shared<GridSampler>(aa_steps)),
+		mode_(mode),
+		min_ray_weight_(0),
+		russian_roulette_(false),
+		is_adaptive_aa_(false),
+		aa_color_tolerance_(0),
+		integrator_(Integrator::whitted),
+		is_denoising_(false),
+		pixel_pattern_(PixelPattern::full),
+		frame_(0),
+		checkpoint_interval_(60) {
+	unsigned tiles_x = (width_ + tile_size_ - 1) / tile_size_;
+	unsigned tiles_y = (height_ + tile_size_ - 1) / tile_size_;
+
+	for (unsigned i = 0; i < tiles_x * tiles_y; ++i) {
+		tile_order_.push_back(i);
+	}
+	std::sort(tile_order_.begin(), tile_order_.end(), [tiles_x](unsigned a, unsigned b) {
+		return morton_code(a % tiles_x, a / tiles_x) < morton_code(b % tiles_x, b / tiles_x);
+	});
+}
+
+void Renderer::set_pruning(float min_weight, bool russian_roulette) {
+	min_ray_weight_ = min_weight;
+	russian_roulette_ = russian_roulette;
+}
+
+void Renderer::set_integrator(Integrator integrator) {
+	integrator_ = integrator;
+}
+
+void Renderer::set_denoising(bool is_denoising, DenoiseOptions const& options) {
+	is_denoising_ = is_denoising;
+	denoise_options_ = options;
+}
+
+void Renderer::set_pixel_pattern(PixelPattern pattern) {
+	pixel_pattern_ = pattern;
+	previous_guides_.clear();
+}
+
+void Renderer::set_frame(unsigned frame) {
+	frame_ = frame;
+}
+
+void Renderer::set_file(std::string const& file) {
+	filename_ = file;
+}
+
+void Renderer::set_checkpoint(std::string const& file, double interval) {
+	checkpoint_file_ = file;
+	checkpoint_interval_ = interval;
+}
+
+void Renderer::set_sampler(std::shared_ptr<Sampler const> sampler) {
+	sampler_ = std::move(sampler);
+}
+
+void Renderer::set_adaptive_aa(bool is_adaptive, float color_tolerance) {
+	is_adaptive_aa_ = is_adaptive;
+	aa_color_tolerance_ = color_tolerance;
+}
 
 #define PI 3.14159265f
 
-void Renderer::render(Scene const& scene) {
-	Camera cam = scene.camera;
+//returns the distance of the image plane and writes the transformation from camera to world space
+float Renderer::prepare_camera(Camera const& cam, glm::mat4& trans_mat) {
 	float fov_radians = cam.fov_x / 180 * PI;
 	float img_plane_dist = (width_ / 2.0f) / tan(fov_radians / 2);
 
 	glm::vec3 u = glm::cross(cam.direction, cam.up);
 	glm::vec3 v = glm::cross(u, cam.direction);
-	glm::mat4 trans_mat{
+	trans_mat = glm::mat4 {
 			glm::vec4{u, 0},
 			glm::vec4{v, 0},
 			glm::vec4{-cam.direction, 0},
 			glm::vec4{cam.position, 1}
 	};
-	//gets amount of parallel threads supported by hardware
-	size_t core_count = std::thread::hardware_concurrency();
-	std::vector<std::thread> threads;
-	threads.resize(core_count);
+	//lets ray cones of camera rays grow by the distance between two anti aliasing samples
+	cone_spread_ = 1.0f / (aa_steps_ * img_plane_dist);
+	return img_plane_dist;
+}
 
+void Renderer::render(Scene const& scene) {
+	render(scene, {{0, 0, width_, height_}});
+}
+
+void Renderer::render(Scene const& scene, std::vector<PixelRect> const& regions) {
+	RenderJob job;
+	render_regions(scene, regions, job);
+}
+
+void Renderer::render_rect(Scene const& scene, PixelRect const& rect) {
+	std::lock_guard<std::mutex> lock {render_mutex_};
+	std::vector<PixelRect> rects = tile_rects({rect});
+	glm::mat4 trans_mat;
+	float img_plane_dist = prepare_camera(scene.camera, trans_mat);
+
+	ThreadPool::global().parallel_for(0, rects.size(), 1, [&](unsigned i) {
+		if (RenderMode::recursive != mode_) {
+			render_tile_wavefront(rects[i], scene, img_plane_dist, trans_mat);
+		} else {
+			render_tile(rects[i], scene, img_plane_dist, trans_mat);
+		}
+	});
+}
+
+std::shared_ptr<RenderJob> Renderer::render_async(Scene const& scene, RenderCallbacks callbacks) {
+	return render_async(scene, {{0, 0, width_, height_}}, std::move(callbacks));
+}
+
+std::shared_ptr<RenderJob> Renderer::render_async(Scene const& scene, std::vector<PixelRect> const& regions, RenderCallbacks callbacks) {
+	auto job = std::make_shared<RenderJob>(std::move(callbacks));
+	//the task only points to the job, the future it is stored in would otherwise keep the job alive forever
+	RenderJob* job_ptr = job.get();
+	job->task_ = std::async(std::launch::async, [this, &scene, regions, job_ptr]() {
+		render_regions(scene, regions, *job_ptr);
+	});
+	return job;
+}
+
+void Renderer::render_regions(Scene const& scene, std::vector<PixelRect> const& regions, RenderJob& job) {
+	std::lock_guard<std::mutex> lock {render_mutex_};
+	std::vector<PixelRect> rects = tile_rects(regions);
+	glm::mat4 trans_mat;
+	float img_plane_dist = prepare_camera(scene.camera, trans_mat);
 	auto start = std::chrono::steady_clock::now();
-	pixel_index_ = 0;
 
-	//starts parallel threads all doing the same task
-	for (std::thread& t : threads) {
-		t = std::thread(&Renderer::thread_function, this, scene, img_plane_dist, trans_mat);
+	//lets the workers of the pool split up the tiles, the scene is shared without copies
+	ThreadPool& pool = ThreadPool::global();
+	bool is_adaptive = is_adaptive_aa_ && aa_steps_ > 1 && RenderMode::recursive == mode_;
+	bool is_reduced = PixelPattern::full != pixel_pattern_ && RenderMode::recursive == mode_ && !is_adaptive;
+	std::vector<PixelSample> first_samples;
+
+	//keeps the surfaces of the previous frame to tell which of its pixels can be reused
+	if (is_reduced && PixelPattern::checkerboard == pixel_pattern_) {
+		std::swap(previous_guides_, guides_);
 	}
-	//lets main thread wait until all parallel threads finished
-	for (std::thread& t : threads) {
-		t.join();
+	guides_.assign(is_denoising_ || is_reduced ? width_ * height_ : 0, GuideSample {});
+	std::vector<std::atomic<bool>> finished_tiles(rects.size());
+	std::vector<PixelRect> remaining_rects;
+	//pixels of the finished tiles, which are copied into it one tile at a time while the other tiles are still rendered
+	Checkpoint checkpoint = make_checkpoint(scene, rects);
+
+	if (resume_tiles(checkpoint, finished_tiles)) {
+		std::cout << "resuming from " << checkpoint_file_ << "\n";
+	}
+	for (unsigned i = 0; i < rects.size(); ++i) {
+		if (!finished_tiles[i]) {
+			remaining_rects.push_back(rects[i]);
+		}
+	}
+	job.start(remaining_rects, aa_steps_ * aa_steps_);
+
+	if (!checkpoint_file_.empty()) {
+		checkpoint.colors = color_buffer_;
+		checkpoint.guides = guides_;
+
+		for (unsigned i = 0; i < rects.size(); ++i) {
+			checkpoint.finished_tiles[i] = finished_tiles[i];
+		}
+	}
+	//guards the checkpoint and the time it was saved
+	std::mutex checkpoint_mutex;
+	auto last_checkpoint = std::chrono::steady_clock::now();
+
+	//samples the whole image once first, so tiles can compare the pixels at their borders with their neighbors
+	if (is_adaptive) {
+		first_samples.resize(width_ * height_);
+		pool.parallel_for(0, rects.size(), 1, [&](unsigned i) {
+			if (!job.is_cancelled()) {
+				sample_tile(rects[i], scene, img_plane_dist, trans_mat, first_samples);
+			}
+		});
+	}
+	pool.parallel_for(0, rects.size(), 1, [&](unsigned i) {
+		if (job.is_cancelled() || finished_tiles[i]) {
+			return;
+		}
+		if (RenderMode::recursive != mode_) {
+			render_tile_wavefront(rects[i], scene, img_plane_dist, trans_mat);
+		} else if (is_adaptive) {
+			render_tile_adaptive(rects[i], scene, img_plane_dist, trans_mat, first_samples);
+		} else if (is_reduced) {
+			render_tile_reduced(rects[i], scene, img_plane_dist, trans_mat);
+		} else {
+			render_tile(rects[i], scene, img_plane_dist, trans_mat);
+		}
+		finished_tiles[i] = true;
+		job.finish_tile(rects[i]);
+
+		if (checkpoint_file_.empty()) {
+			return;
+		}
+		//threads finishing a tile while a checkpoint is saved wait for it, which is rare compared to copying a tile
+		std::lock_guard<std::mutex> lock {checkpoint_mutex};
+		copy_tile(i, rects[i], checkpoint);
+		std::chrono::duration<double> since_checkpoint = std::chrono::steady_clock::now() - last_checkpoint;
+
+		if (since_checkpoint.count() >= checkpoint_interval_) {
+			save_tiles(checkpoint);
+			last_checkpoint = std::chrono::steady_clock::now();
+		}
+	});
+	//fills in the missing pixels once all their neighbors in other tiles are traced
+	if (is_reduced && !job.is_cancelled()) {
+		pool.parallel_for(0, rects.size(), 1, [&](unsigned i) {
+			reconstruct_rect(rects[i], scene, img_plane_dist, trans_mat);
+		});
 	}
 	auto end = std::chrono::steady_clock::now();
 	std::chrono::duration<double> elapsed_seconds = end-start;
-	std::cout << elapsed_seconds.count() << "s rendering\n";
+	std::cout << elapsed_seconds.count() << "s rendering" << (job.is_cancelled() ? " cancelled\n" : "\n");
 
+	if (is_denoising_ && !job.is_cancelled()) {
+		denoise_image(rects);
+	}
+	if (!checkpoint_file_.empty() && job.is_cancelled()) {
+		save_tiles(checkpoint);
+	} else if (!checkpoint_file_.empty()) {
+		std::remove(checkpoint_file_.c_str());
+	}
 	ppm_.save(filename_);
 }
 
-void Renderer::thread_function(Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
-	float aa_unit = 1.0f / aa_steps_;
-	//continuously picks pixels to render
+void Renderer::render_progressive(Scene const& scene, ProgressiveStop const& stop) {
+	std::lock_guard<std::mutex> lock {render_mutex_};
+	std::vector<PixelRect> rects = tile_rects({{0, 0, width_, height_}});
+	glm::mat4 trans_mat;
+	float img_plane_dist = prepare_camera(scene.camera, trans_mat);
+	auto start = std::chrono::steady_clock::now();
+	unsigned max_samples = stop.max_samples;
+
+	if (0 == stop.time_budget && 0 == stop.max_samples && 0 == stop.noise_target) {
+		max_samples = aa_steps_ * aa_steps_;
+	}
+	accumulation_.assign(width_ * height_, Color {});
+	brightness_sums_.assign(width_ * height_, 0);
+	brightness_squares_.assign(width_ * height_, 0);
+	sample_count_ = 0;
+	noise_ = 0;
+	guides_.assign(is_denoising_ ? width_ * height_ : 0, GuideSample {});
+
+	Checkpoint settings = make_checkpoint(scene, {});
+
+	if (resume_passes(settings)) {
+		std::cout << "resuming from " << checkpoint_file_ << " after " << sample_count_ << " samples\n";
+	}
+	auto last_checkpoint = std::chrono::steady_clock::now();
+
 	while (true) {
-		unsigned current_pixel = pixel_index_++;
-		unsigned x = current_pixel % width_;
-		unsigned y = current_pixel / width_;
+		ThreadPool::global().parallel_for(0, rects.size(), 1, [&](unsigned i) {
+			render_pass_tile(rects[i], scene, img_plane_dist, trans_mat);
+		});
+		++sample_count_;
+		noise_ = estimate_noise();
+		std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start;
+		std::chrono::duration<double> since_checkpoint = std::chrono::steady_clock::now() - last_checkpoint;
 
-		if (current_pixel >= width_ * height_) {
-			return;
+		if (!checkpoint_file_.empty() && since_checkpoint.count() >= checkpoint_interval_) {
+			save_passes(settings);
+			last_checkpoint = std::chrono::steady_clock::now();
+		}
+
+		if ((0 != max_samples && sample_count_ >= max_samples) ||
+		    (0 != stop.time_budget && elapsed_seconds.count() >= stop.time_budget) ||
+		    (0 != stop.noise_target && sample_count_ > 1 && noise_ <= stop.noise_target)) {
+			break;
+		}
+	}
+	std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start;
+	std::cout << elapsed_seconds.count() << "s rendering " << sample_count_ << " samples\n";
+
+	if (is_denoising_) {
+		denoise_image(rects);
+	}
+	if (!checkpoint_file_.empty()) {
+		std::remove(checkpoint_file_.c_str());
+	}
+	ppm_.save(filename_);
+}
+
+bool same_rect(PixelRect const& a, PixelRect const& b) {
+	return a.min_x == b.min_x && a.min_y == b.min_y && a.max_x == b.max_x && a.max_y == b.max_y;
+}
+
+uint32_t float_bits(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+uint32_t hash_floats(uint32_t hash, std::initializer_list<float> values) {
+	for (float value : values) {
+		hash = hash_bits(hash ^ float_bits(value));
+	}
+	return hash;
+}
+
+//fingerprint of the camera, lights, materials and shapes of a scene, which tells if a checkpoint still shows it
+uint32_t hash_scene(Scene const& scene) {
+	Camera const& camera = scene.camera;
+	glm::vec3 min = scene.root->min();
+	glm::vec3 max = scene.root->max();
+	uint32_t hash = hash_floats(0, {
+			camera.fov_x, camera.position.x, camera.position.y, camera.position.z,
+			camera.direction.x, camera.direction.y, camera.direction.z, camera.up.x, camera.up.y, camera.up.z,
+			scene.ambient.intensity.r, scene.ambient.intensity.g, scene.ambient.intensity.b,
+			min.x, min.y, min.z, max.x, max.y, max.z});
+
+	for (PointLight const& light : scene.lights) {
+		hash = hash_floats(hash, {
+				light.position.x, light.position.y, light.position.z,
+				light.intensity.r, light.intensity.g, light.intensity.b, light.radius});
+	}
+	//shapes of the flattened hierarchy, transformed composites and instances count as one shape with their bounds
+	for (auto const& primitive : scene.root->primitives()) {
+		glm::vec3 shape_min = primitive->min();
+		glm::vec3 shape_max = primitive->max();
+		glm::mat4 const& transform = primitive->world_transform();
+		hash = hash_floats(hash, {shape_min.x, shape_min.y, shape_min.z, shape_max.x, shape_max.y, shape_max.z});
+
+		for (int column = 0; column < 4; ++column) {
+			hash = hash_floats(hash, {transform[column].x, transform[column].y, transform[column].z, transform[column].w});
+		}
+	}
+	for (auto const& it : scene.materials) {
+		Material const& mat = *it.second;
+		hash = hash_bits(hash ^ (uint32_t) std::hash<std::string> {}(it.first));
+		hash = hash_floats(hash, {
+				mat.ka.r, mat.ka.g, mat.ka.b, mat.kd.r, mat.kd.g, mat.kd.b, mat.ks.r, mat.ks.g, mat.ks.b,
+				mat.m, mat.glossy, mat.opacity, mat.ior});
+	}
+	return hash;
+}
+
+//samples only depend on their arguments, so a few of them tell samplers of other types or grid sizes apart
+uint32_t hash_sampler(Sampler const& sampler) {
+	uint32_t hash = 0;
+
+	for (unsigned dimension = 0; dimension < 2; ++dimension) {
+		for (unsigned i = 0; i < 16; ++i) {
+			glm::vec2 sample = sampler.sample(1, 2, i, dimension);
+			hash = hash_floats(hash, {sample.x, sample.y});
+		}
+	}
+	return hash;
+}
+
+Checkpoint Renderer::make_checkpoint(Scene const& scene, std::vector<PixelRect> const& rects) const {
+	Checkpoint checkpoint;
+	checkpoint.width = width_;
+	checkpoint.height = height_;
+	checkpoint.aa_steps = aa_steps_;
+	//hashing every shape takes a while for big scenes, so only renders that save checkpoints do it
+	checkpoint.scene_hash = checkpoint_file_.empty() ? 0 : hash_scene(scene);
+	checkpoint.sampler_hash = hash_sampler(*sampler_);
+	checkpoint.integrator = (unsigned) integrator_;
+	checkpoint.render_mode = (unsigned) mode_;
+	checkpoint.max_ray_bounces = max_ray_bounces_;
+	checkpoint.frame = frame_;
+	checkpoint.rects = rects;
+	checkpoint.finished_tiles.assign(rects.size(), 0);
+	return checkpoint;
+}
+
+//restores the finished tiles of a checkpoint of the same tiles and settings
+bool Renderer::resume_tiles(Checkpoint const& expected, std::vector<std::atomic<bool>>& finished_tiles) {
+	Checkpoint checkpoint;
+	std::vector<PixelRect> const& rects = expected.rects;
+
+	if (checkpoint_file_.empty() || !load_checkpoint(checkpoint_file_, checkpoint) || !same_settings(checkpoint, expected) ||
+	    checkpoint.rects.size() != rects.size() || checkpoint.finished_tiles.size() != rects.size() ||
+	    checkpoint.colors.size() != color_buffer_.size() ||
+	    !std::equal(rects.begin(), rects.end(), checkpoint.rects.begin(), same_rect)) {
+		return false;
+	}
+	bool has_guides = !guides_.empty() && checkpoint.guides.size() == guides_.size();
+
+	for (unsigned i = 0; i < rects.size(); ++i) {
+		if (!checkpoint.finished_tiles[i]) {
+			continue;
+		}
+		finished_tiles[i] = true;
+
+		for (unsigned y = rects[i].min_y; y < rects[i].max_y; ++y) {
+			for (unsigned x = rects[i].min_x; x < rects[i].max_x; ++x) {
+				Pixel pixel {x, y};
+				pixel.color = checkpoint.colors[y * width_ + x];
+				write(pixel);
+
+				if (has_guides) {
+					guides_[y * width_ + x] = checkpoint.guides[y * width_ + x];
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void Renderer::copy_tile(unsigned tile, PixelRect const& rect, Checkpoint& checkpoint) const {
+	for (unsigned y = rect.min_y; y < rect.max_y; ++y) {
+		unsigned row = y * width_;
+		std::copy(color_buffer_.begin() + row + rect.min_x, color_buffer_.begin() + row + rect.max_x, checkpoint.colors.begin() + row + rect.min_x);
+
+		if (!guides_.empty()) {
+			std::copy(guides_.begin() + row + rect.min_x, guides_.begin() + row + rect.max_x, checkpoint.guides.begin() + row + rect.min_x);
+		}
+	}
+	checkpoint.finished_tiles[tile] = 1;
+}
+
+void Renderer::save_tiles(Checkpoint const& checkpoint) const {
+	if (!save_checkpoint(checkpoint_file_, checkpoint)) {
+		std::cerr << "could not save checkpoint " << checkpoint_file_ << std::endl;
+	}
+}
+
+//restores the sums of all passes of a progressive checkpoint of the same settings
+bool Renderer::resume_passes(Checkpoint const& expected) {
+	Checkpoint checkpoint;
+	unsigned pixel_count = width_ * height_;
+
+	if (checkpoint_file_.empty() || !load_checkpoint(checkpoint_file_, checkpoint) || !same_settings(checkpoint, expected) ||
+	    0 == checkpoint.sample_count || !checkpoint.rects.empty() || checkpoint.accumulation.size() != pixel_count ||
+	    checkpoint.brightness_sums.size() != pixel_count || checkpoint.brightness_squares.size() != pixel_count) {
+		return false;
+	}
+	accumulation_ = std::move(checkpoint.accumulation);
+	brightness_sums_ = std::move(checkpoint.brightness_sums);
+	brightness_squares_ = std::move(checkpoint.brightness_squares);
+	sample_count_ = checkpoint.sample_count;
+
+	if (checkpoint.guides.size() == guides_.size()) {
+		guides_ = std::move(checkpoint.guides);
+	}
+	return true;
+}
+
+void Renderer::save_passes(Checkpoint checkpoint) const {
+	checkpoint.sample_count = sample_count_;
+	checkpoint.accumulation = accumulation_;
+	checkpoint.brightness_sums = brightness_sums_;
+	checkpoint.brightness_squares = brightness_squares_;
+	checkpoint.guides = guides_;
+
+	if (!save_checkpoint(checkpoint_file_, checkpoint)) {
+		std::cerr << "could not save checkpoint " << checkpoint_file_ << std::endl;
+	}
+}
+
+//cuts the regions into the parts of the tiles they cover, in the order the tiles are rendered
+std::vector<PixelRect> Renderer::tile_rects(std::vector<PixelRect> const& regions) const {
+	unsigned tiles_x = (width_ + tile_size_ - 1) / tile_size_;
+	std::vector<PixelRect> rects;
+
+	for (unsigned tile : tile_order_) {
+		unsigned min_x = (tile % tiles_x) * tile_size_;
+		unsigned min_y = (tile / tiles_x) * tile_size_;
+
+		for (PixelRect const& region : regions) {
+			PixelRect rect {
+					std::max(min_x, region.min_x),
+					std::max(min_y, region.min_y),
+					std::min({min_x + tile_size_, region.max_x, width_}),
+					std::min({min_y + tile_size_, region.max_y, height_})};
+
+			if (rect.min_x < rect.max_x && rect.min_y < rect.max_y) {
+				rects.push_back(rect);
+			}
+		}
+	}
+	return rects;
+}
+
+bool Renderer::load_image(std::string const& file) {
+	std::ifstream stream(file);
+	std::string format;
+	unsigned width;
+	unsigned height;
+	unsigned max_value;
+
+	if (!(stream >> format >> width >> height >> max_value) || "P3" != format || width != width_ || height != height_) {
+		return false;
+	}
+	//the rows of the file go from the top of the image to the bottom, the opposite of the pixel rows
+	for (unsigned i = 0; i < width_ * height_; ++i) {
+		unsigned r;
+		unsigned g;
+		unsigned b;
+
+		if (!(stream >> r >> g >> b)) {
+			return false;
+		}
+		Pixel pixel {i % width_, height_ - 1 - i / width_};
+		pixel.color = Color {(float) r, (float) g, (float) b} * (1.0f / max_value);
+		write(pixel);
+	}
+	return true;
+}
+
+void Renderer::save() {
+	ppm_.save(filename_);
+}
+
+void Renderer::save_crop(std::string const& file, PixelRect const& rect) const {
+	unsigned max_x = std::min(rect.max_x, width_);
+	unsigned max_y = std::min(rect.max_y, height_);
+
+	if (rect.min_x >= max_x || rect.min_y >= max_y) {
+		return;
+	}
+	PpmWriter crop {max_x - rect.min_x, max_y - rect.min_y};
+
+	for (unsigned y = rect.min_y; y < max_y; ++y) {
+		for (unsigned x = rect.min_x; x < max_x; ++x) {
+			Pixel pixel {x - rect.min_x, y - rect.min_y};
+			pixel.color = color_buffer_[y * width_ + x];
+			crop.write(pixel);
+		}
+	}
+	crop.save(file);
+}
+
+unsigned Renderer::sample_count() const {
+	return sample_count_;
+}
+
+float Renderer::noise() const {
+	return noise_;
+}
+
+//adds the surface a camera ray hit to the guide of its pixel
+void add_guide(GuideSample& guide, HitPoint const& hit, float weight) {
+	if (!hit.does_intersect) {
+		return;
+	}
+	guide.albedo += hit.hit_material->kd * weight;
+	guide.normal += hit.surface_normal * weight;
+	guide.depth += hit.distance * weight;
+}
+
+void Renderer::render_pass_tile(
+		PixelRect const& rect,
+		Scene const& scene,
+		float img_plane_dist,
+		glm::mat4 const& trans_mat) {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	std::vector<Ray> rays;
+	std::vector<HitPoint> hits;
+
+	for (unsigned y = min_y; y < max_y; ++y) {
+		for (unsigned x = min_x; x < max_x; ++x) {
+			rays.push_back(camera_ray(x, y, sample_count_, img_plane_dist, trans_mat));
+		}
+	}
+	trace_packets(rays, scene, hits);
+	float sample_weight = 1.0f / (sample_count_ + 1);
+
+	for (unsigned i = 0; i < rays.size(); ++i) {
+		Pixel pixel {min_x + i % (max_x - min_x), min_y + i / (max_x - min_x)};
+		unsigned buf_pos = pixel.y * width_ + pixel.x;
+		Color color = shade_sample(rays[i], hits[i], scene, pixel.x, pixel.y, sample_count_);
+		Color tone_mapped = tone_map_color(color);
+		float brightness = (tone_mapped.r + tone_mapped.g + tone_mapped.b) / 3;
+
+		accumulation_[buf_pos] += color;
+		brightness_sums_[buf_pos] += brightness;
+		brightness_squares_[buf_pos] += brightness * brightness;
+		pixel.color = tone_map_color(accumulation_[buf_pos] * sample_weight);
+		write(pixel);
+
+		if (!guides_.empty()) {
+			GuideSample& guide = guides_[buf_pos];
+			guide.albedo *= 1 - sample_weight;
+			guide.normal *= 1 - sample_weight;
+			guide.depth *= 1 - sample_weight;
+			add_guide(guide, hits[i], sample_weight);
+		}
+	}
+}
+
+void Renderer::denoise_image(std::vector<PixelRect> const& rects) {
+	auto start = std::chrono::steady_clock::now();
+	std::vector<Color> colors(color_buffer_.size());
+
+	//undoes the tone mapping, so the filter blurs the light the pixels actually received
+	for (unsigned i = 0; i < colors.size(); ++i) {
+		Color const& color = color_buffer_[i];
+		colors[i] = {color.r / std::max(1e-6f, 1 - color.r), color.g / std::max(1e-6f, 1 - color.g), color.b / std::max(1e-6f, 1 - color.b)};
+	}
+	denoise(colors, guides_, width_, height_, denoise_options_);
+
+	//keeps the pixels outside of the rendered regions as they are
+	for (PixelRect const& rect : rects) {
+		for (unsigned y = rect.min_y; y < rect.max_y; ++y) {
+			for (unsigned x = rect.min_x; x < rect.max_x; ++x) {
+				Pixel pixel {x, y};
+				pixel.color = tone_map_color(colors[y * width_ + x]);
+				write(pixel);
+			}
+		}
+	}
+	std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start;
+	std::cout << elapsed_seconds.count() << "s denoising\n";
+}
+
+float Renderer::estimate_noise() const {
+	if (sample_count_ < 2) {
+		return 0;
+	}
+	float samples = sample_count_;
+	float error_sum = 0;
+
+	for (unsigned i = 0; i < brightness_sums_.size(); ++i) {
+		float mean = brightness_sums_[i] / samples;
+		float variance = std::max(0.0f, (brightness_squares_[i] - samples * mean * mean) / (samples - 1));
+		error_sum += std::sqrt(variance / samples);
+	}
+	return error_sum / brightness_sums_.size();
+}
+
+void Renderer::render_tile(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	//blocks of pixels whose anti aliasing samples fill about one ray packet
+	unsigned block_size = std::max(1u, 4 / aa_steps_);
+	//collects the pixels of the tile first, so threads only write to the shared buffers once per tile
+	std::vector<Pixel> tile_pixels;
+	std::vector<GuideSample> tile_guides;
+	tile_pixels.reserve(tile_size_ * tile_size_);
+
+	for (unsigned y = min_y; y < max_y; y += block_size) {
+		for (unsigned x = min_x; x < max_x; x += block_size) {
+			render_block(x, y, std::min(x + block_size, max_x), std::min(y + block_size, max_y), scene, img_plane_dist, trans_mat,
+			             tile_pixels, tile_guides);
+		}
+	}
+	for (unsigned i = 0; i < tile_pixels.size(); ++i) {
+		write(tile_pixels[i]);
+
+		if (!guides_.empty()) {
+			guides_[tile_pixels[i].y * width_ + tile_pixels[i].x] = tile_guides[i];
+		}
+	}
+}
+
+void Renderer::render_block(
+		unsigned min_x,
+		unsigned min_y,
+		unsigned max_x,
+		unsigned max_y,
+		Scene const& scene,
+		float img_plane_dist,
+		glm::mat4 const& trans_mat,
+		std::vector<Pixel>& pixels,
+		std::vector<GuideSample>& guides) const {
+	unsigned samples = aa_steps_ * aa_steps_;
+	unsigned first_pixel = pixels.size();
+	std::vector<Ray> rays;
+
+	for (unsigned y = min_y; y < max_y; ++y) {
+		for (unsigned x = min_x; x < max_x; ++x) {
+			for (unsigned sample = 0; sample < samples; ++sample) {
+				rays.push_back(camera_ray(x, y, sample, img_plane_dist, trans_mat));
+			}
+			pixels.emplace_back(x, y);
+			guides.emplace_back();
+		}
+	}
+	//traces neighboring camera rays together and shades their hits one by one
+	std::vector<Color> traced_colors(pixels.size() - first_pixel);
+	std::vector<HitPoint> hits;
+	trace_packets(rays, scene, hits);
+
+	for (unsigned i = 0; i < rays.size(); ++i) {
+		Pixel const& pixel = pixels[first_pixel + i / samples];
+		traced_colors[i / samples] += shade_sample(rays[i], hits[i], scene, pixel.x, pixel.y, i % samples);
+		add_guide(guides[first_pixel + i / samples], hits[i], 1.0f / samples);
+	}
+	for (unsigned i = 0; i < traced_colors.size(); ++i) {
+		pixels[first_pixel + i].color = tone_map_color(traced_colors[i] * (1.0f / samples));
+	}
+}
+
+Ray Renderer::camera_ray(unsigned x, unsigned y, unsigned sample, float img_plane_dist, glm::mat4 const& trans_mat) const {
+	glm::vec2 offset = sampler_->sample(x, y, sample, 0, frame_);
+	glm::vec3 pixel_pos = glm::vec3{
+			x + offset.x - (width_ * 0.5f),
+			y + offset.y - (height_ * 0.5f),
+			-img_plane_dist};
+
+	glm::vec4 trans_ray_dir = trans_mat * glm::vec4{ glm::normalize(pixel_pos), 0 };
+	return Ray{ glm::vec3{trans_mat[3]}, glm::vec3{trans_ray_dir}, 0, cone_spread_ };
+}
+
+//random numbers of the sample the thread is shading, which only depend on the sample and not on the thread
+thread_local uint32_t random_seed = 0;
+thread_local uint32_t random_draws = 0;
+
+void seed_random(unsigned x, unsigned y, unsigned sample, unsigned frame) {
+	random_seed = hash_bits(x, y, hash_bits(sample, frame, 0));
+	random_draws = 0;
+}
+
+//next random number in [0, 1) of the sample seeded last
+float next_random() {
+	return to_unit_float(hash_bits(random_seed, random_draws++, 0));
+}
+
+bool is_black(Color const& color) {
+	return 0 == color.r && 0 == color.g && 0 == color.b;
+}
+
+float max_component(Color const& color) {
+	return std::max(color.r, std::max(color.g, color.b));
+}
+
+//intensity of a light at a distance, all lights fall off with the squared distance so a light sphere shrunk to a point
+//lights the same as a point light
+Color incident_intensity(PointLight const& light, float distance) {
+	return light.intensity * (1 / (distance * distance));
+}
+
+void Renderer::render_tile_wavefront(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	unsigned tile_width = max_x - min_x;
+	unsigned block_size = std::max(1u, 4 / aa_steps_);
+	unsigned samples = aa_steps_ * aa_steps_;
+
+	//generates the camera rays block by block, so rays next to each other in the queue also form coherent packets
+	RayQueue rays;
+	std::vector<Color> colors(tile_width * (max_y - min_y));
+
+	for (unsigned block_y = min_y; block_y < max_y; block_y += block_size) {
+		for (unsigned block_x = min_x; block_x < max_x; block_x += block_size) {
+			for (unsigned y = block_y; y < std::min(block_y + block_size, max_y); ++y) {
+				for (unsigned x = block_x; x < std::min(block_x + block_size, max_x); ++x) {
+					for (unsigned sample = 0; sample < samples; ++sample) {
+						rays.push(camera_ray(x, y, sample, img_plane_dist, trans_mat), Color {1, 1, 1}, (y - min_y) * tile_width + x - min_x, sample);
+					}
+				}
+			}
 		}
-		Color traced_color{};
+	}
+	//every wave holds the rays with one more bounce than the previous one
+	RayQueue next_rays;
+	ShadowQueue shadows;
+	std::vector<HitPoint> hits;
 
-		for (int aax = 0; aax < aa_steps_; ++aax) {
-			for (int aay = 0; aay < aa_steps_; ++aay) {
-				glm::vec3 pixel_pos = glm::vec3{
-						x + aax * aa_unit - (width_ * 0.5f),
-						y + aay * aa_unit - (height_ * 0.5f),
-						-img_plane_dist};
+	for (unsigned ray_bounces = 0; !rays.empty(); ++ray_bounces) {
+		//camera rays are coherent already, the rays of later waves go all directions
+		if (ray_bounces > 0 && RenderMode::sorted_wavefront == mode_) {
+			rays.sort();
+		}
+		extend(rays, scene, hits);
 
-				glm::vec4 trans_ray_dir = trans_mat * glm::vec4{ glm::normalize(pixel_pos), 0 };
-				Ray ray{ glm::vec3{trans_mat[3]}, glm::vec3{trans_ray_dir} };
-				traced_color += trace(ray, scene);
+		if (0 == ray_bounces && !guides_.empty()) {
+			for (unsigned i = 0; i < rays.size(); ++i) {
+				unsigned pixel = rays.pixels[i];
+				add_guide(guides_[(min_y + pixel / tile_width) * width_ + min_x + pixel % tile_width], hits[i], 1.0f / samples);
 			}
 		}
-		traced_color *= 1.0f / (aa_steps_ * aa_steps_);
-		Pixel pixel{ x, y };
-		pixel.color = tone_map_color(traced_color);
+		shade_wave(rect, rays, hits, scene, ray_bounces, colors, shadows, next_rays);
+		trace_shadows(shadows, scene, colors);
+		std::swap(rays, next_rays);
+		next_rays.clear();
+		shadows.clear();
+	}
+	for (unsigned i = 0; i < colors.size(); ++i) {
+		Pixel pixel {min_x + i % tile_width, min_y + i / tile_width};
+		pixel.color = tone_map_color(colors[i] * (1.0f / samples));
 		write(pixel);
 	}
 }
 
+void Renderer::extend(RayQueue const& rays, Scene const& scene, std::vector<HitPoint>& hits) const {
+	hits.assign(rays.size(), HitPoint {});
+
+	for (unsigned first_ray = 0; first_ray < rays.size(); first_ray += PACKET_SIZE) {
+		RayPacket packet {};
+
+		for (unsigned i = first_ray; i < std::min<unsigned>(first_ray + PACKET_SIZE, rays.size()); ++i) {
+			packet.add(rays.ray(i));
+		}
+		scene.root->intersect_packet(packet, &hits[first_ray]);
+	}
+}
+
+//kinds of bounces hashed into the path numbers of the rays they spawn
+#define REFLECTED_PATH 1
+#define REFRACTED_PATH 2
+
+//splits the light of each hit into the same shares as shade() and queues the rays it needs for them
+void Renderer::shade_wave(
+		PixelRect const& rect,
+		RayQueue const& rays,
+		std::vector<HitPoint>& hits,
+		Scene const& scene,
+		unsigned ray_bounces,
+		std::vector<Color>& colors,
+		ShadowQueue& shadows,
+		RayQueue& next_rays) const {
+	for (unsigned i = 0; i < rays.size(); ++i) {
+		HitPoint& hit_point = hits[i];
+
+		if (!hit_point.does_intersect) {
+			continue;
+		}
+		if (0 == hit_point.footprint) {
+			hit_point.footprint = rays.ray(i).footprint(hit_point.distance);
+		}
+		auto material = hit_point.hit_material;
+		Color weight = rays.weights[i];
+		unsigned pixel = rays.pixels[i];
+		unsigned path = rays.paths[i];
+		Color local_weight = weight * material->opacity;
+		//seeds from the pixel, the path of the ray within it and the bounce, which stay the same in any order of the rays
+		unsigned tile_width = rect.max_x - rect.min_x;
+		seed_random(rect.min_x + pixel % tile_width, rect.min_y + pixel / tile_width, hash_bits(path, ray_bounces, 0), frame_);
+
+		if (ray_bounces < max_ray_bounces_) {
+			unsigned reflected_path = hash_bits(path, REFLECTED_PATH, 0);
+			unsigned refracted_path = hash_bits(path, REFRACTED_PATH, 0);
+
+			if (material->glossy > 0 && material->opacity < 1) {
+				float reflectance = schlick_reflection_ratio(hit_point.ray_direction, hit_point.surface_normal, material->ior);
+				local_weight *= reflectance * material->opacity;
+				queue_reflection(hit_point, weight * reflectance, pixel, reflected_path, next_rays);
+				queue_refraction(hit_point, weight * ((1 - reflectance) * (1 - material->opacity)), pixel, refracted_path, next_rays);
+			} else if (material->glossy > 0) {
+				float reflectance = schlick_reflection_ratio(hit_point.ray_direction, hit_point.surface_normal, material->ior);
+				reflectance = material->glossy + (1 - material->glossy) * reflectance;
+				local_weight *= 1 - reflectance;
+				queue_reflection(hit_point, weight * reflectance, pixel, reflected_path, next_rays);
+			} else if (material->opacity < 1) {
+				local_weight *= material->opacity;
+				queue_refraction(hit_point, weight * (1 - material->opacity), pixel, refracted_path, next_rays);
+			}
+		}
+		if (!is_black(local_weight)) {
+			queue_direct_light(hit_point, local_weight, pixel, scene, colors, shadows);
+		}
+	}
+}
+
+void Renderer::queue_direct_light(
+		HitPoint const& hit_point,
+		Color const& weight,
+		unsigned pixel,
+		Scene const& scene,
+		std::vector<Color>& colors,
+		ShadowQueue& shadows) const {
+	auto material = hit_point.hit_material;
+	colors[pixel] += scene.ambient.intensity * material->ka * weight;
+
+	for (PointLight const& light : scene.lights) {
+		glm::vec3 light_dir = light.position - hit_point.position;
+		float distance = glm::length(light_dir);
+		light_dir = glm::normalize(light_dir);
+		float cos_view_angle = glm::dot(hit_point.surface_normal, light_dir);
+		//lights behind the surface need no shadow ray
+		if (cos_view_angle < 0) {
+			continue;
+		}
+		Color intensity = incident_intensity(light, distance);
+		Color light_color = intensity * material->kd * cos_view_angle;
+
+		if (material->m != 0) {
+			light_color += specular_color(hit_point.ray_direction, light_dir, hit_point.surface_normal, intensity, material);
+		}
+		shadows.push({hit_point.position, light_dir, hit_point.footprint}, distance - light.radius, light_color * weight, pixel);
+	}
+}
+
+void Renderer::queue_ray(Ray const& ray, Color const& weight, unsigned pixel, unsigned path, RayQueue& next_rays) const {
+	float survival = survival_probability(weight);
+
+	if (0 != survival) {
+		next_rays.push(ray, weight * (1 / survival), pixel, path);
+	}
+}
+
+void Renderer::queue_reflection(HitPoint const& hit_point, Color const& weight, unsigned pixel, unsigned path,
+                                RayQueue& next_rays) const {
+	queue_ray(reflected_ray(hit_point), weight * hit_point.hit_material->ks, pixel, path, next_rays);
+}
+
+void Renderer::queue_refraction(HitPoint const& hit_point, Color const& weight, unsigned pixel, unsigned path,
+                                RayQueue& next_rays) const {
+	Ray refracted;
+
+	if (refracted_ray(hit_point, refracted)) {
+		queue_ray(refracted, weight * hit_point.hit_material->kd, pixel, path, next_rays);
+	} else {
+		queue_reflection(hit_point, weight, pixel, path, next_rays);
+	}
+}
+
+void Renderer::trace_shadows(ShadowQueue const& shadows, Scene const& scene, std::vector<Color>& colors) const {
+	for (unsigned first_ray = 0; first_ray < shadows.size(); first_ray += PACKET_SIZE) {
+		RayPacket packet {};
+		HitPoint hits[PACKET_SIZE];
+		unsigned last_ray = std::min<unsigned>(first_ray + PACKET_SIZE, shadows.size());
+
+		//pretends a hit at the light, so shapes only report hits that block it and skip everything behind it
+		for (unsigned i = first_ray; i < last_ray; ++i) {
+			packet.add(shadows.ray(i));
+			hits[i - first_ray].does_intersect = true;
+			hits[i - first_ray].distance = shadows.ranges[i];
+		}
+		scene.root->intersect_packet(packet, hits);
+
+		for (unsigned i = first_ray; i < last_ray; ++i) {
+			if (hits[i - first_ray].distance >= shadows.ranges[i]) {
+				colors[shadows.pixels[i]] += shadows.contributions[i];
+			}
+		}
+	}
+}
+
+void Renderer::trace_packets(std::vector<Ray> const& rays, Scene const& scene, std::vector<HitPoint>& hits) const {
+	hits.assign(rays.size(), HitPoint {});
+
+	for (unsigned first_ray = 0; first_ray < rays.size(); first_ray += PACKET_SIZE) {
+		RayPacket packet {};
+
+		for (unsigned i = first_ray; i < std::min<unsigned>(first_ray + PACKET_SIZE, rays.size()); ++i) {
+			packet.add(rays[i]);
+		}
+		scene.root->intersect_packet(packet, &hits[first_ray]);
+	}
+}
+
+//thresholds of the geometry differences between neighboring pixels that get anti aliased
+#define AA_DEPTH_TOLERANCE 0.05f
+#define AA_NORMAL_TOLERANCE 0.95f
+
+//traces the first sample of the anti aliasing grid of every pixel in the tile
+void Renderer::sample_tile(
+		PixelRect const& rect,
+		Scene const& scene,
+		float img_plane_dist,
+		glm::mat4 const& trans_mat,
+		std::vector<PixelSample>& first_samples) const {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	std::vector<Ray> rays;
+	std::vector<HitPoint> hits;
+
+	for (unsigned y = min_y; y < max_y; ++y) {
+		for (unsigned x = min_x; x < max_x; ++x) {
+			rays.push_back(camera_ray(x, y, 0, img_plane_dist, trans_mat));
+		}
+	}
+	trace_packets(rays, scene, hits);
+
+	for (unsigned i = 0; i < rays.size(); ++i) {
+		unsigned x = min_x + i % (max_x - min_x);
+		unsigned y = min_y + i / (max_x - min_x);
+		PixelSample& sample = first_samples[y * width_ + x];
+		sample.color = shade_sample(rays[i], hits[i], scene, x, y, 0);
+		sample.does_intersect = hits[i].does_intersect;
+		sample.distance = hits[i].distance;
+		sample.normal = hits[i].surface_normal;
+		sample.object_id = std::hash<std::string> {}(hits[i].hit_object);
+		sample.albedo = hits[i].does_intersect ? hits[i].hit_material->kd : Color {};
+	}
+}
+
+void Renderer::render_tile_adaptive(
+		PixelRect const& rect,
+		Scene const& scene,
+		float img_plane_dist,
+		glm::mat4 const& trans_mat,
+		std::vector<PixelSample> const& first_samples) {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	unsigned samples = aa_steps_ * aa_steps_;
+	//collects the rest of the sample grids of all pixels that differ from a neighbor
+	std::vector<Pixel> tile_pixels;
+	std::vector<unsigned> refined_pixels;
+	std::vector<Ray> rays;
+
+	for (unsigned y = min_y; y < max_y; ++y) {
+		for (unsigned x = min_x; x < max_x; ++x) {
+			unsigned i = y * width_ + x;
+			tile_pixels.emplace_back(x, y);
+
+			if (!guides_.empty() && first_samples[i].does_intersect) {
+				guides_[i] = {first_samples[i].albedo, first_samples[i].normal, first_samples[i].distance};
+			}
+			bool is_refined =
+					(x > 0 && needs_refinement(first_samples[i], first_samples[i - 1])) ||
+					(x + 1 < width_ && needs_refinement(first_samples[i], first_samples[i + 1])) ||
+					(y > 0 && needs_refinement(first_samples[i], first_samples[i - width_])) ||
+					(y + 1 < height_ && needs_refinement(first_samples[i], first_samples[i + width_]));
+
+			if (!is_refined) {
+				tile_pixels.back().color = tone_map_color(first_samples[i].color);
+				continue;
+			}
+			for (unsigned sample = 1; sample < samples; ++sample) {
+				rays.push_back(camera_ray(x, y, sample, img_plane_dist, trans_mat));
+			}
+			refined_pixels.push_back(tile_pixels.size() - 1);
+		}
+	}
+	std::vector<HitPoint> hits;
+	trace_packets(rays, scene, hits);
+
+	//adds the samples up in the same order as a full grid would
+	for (unsigned i = 0; i < refined_pixels.size(); ++i) {
+		Pixel& pixel = tile_pixels[refined_pixels[i]];
+		Color traced_color = first_samples[pixel.y * width_ + pixel.x].color;
+
+		for (unsigned sample = 1; sample < samples; ++sample) {
+			unsigned ray = i * (samples - 1) + sample - 1;
+			traced_color += shade_sample(rays[ray], hits[ray], scene, pixel.x, pixel.y, sample);
+		}
+		pixel.color = tone_map_color(traced_color * (1.0f / samples));
+	}
+	for (Pixel const& pixel : tile_pixels) {
+		write(pixel);
+	}
+}
+
+bool Renderer::is_traced(unsigned x, unsigned y) const {
+	switch (pixel_pattern_) {
+		case PixelPattern::half_resolution:
+			return 0 == x % 2 && 0 == y % 2;
+		case PixelPattern::checkerboard:
+			return 0 == (x + y + frame_) % 2;
+		default:
+			return true;
+	}
+}
+
+//traces all samples of the pixels of the pattern, the others are left to reconstruct_rect
+void Renderer::render_tile_reduced(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
+	unsigned min_x = rect.min_x;
+	unsigned min_y = rect.min_y;
+	unsigned max_x = rect.max_x;
+	unsigned max_y = rect.max_y;
+	unsigned samples = aa_steps_ * aa_steps_;
+	std::vector<Pixel> tile_pixels;
+	std::vector<Ray> rays;
+
+	for (unsigned y = min_y; y < max_y; ++y) {
+		for (unsigned x = min_x; x < max_x; ++x) {
+			if (!is_traced(x, y)) {
+				continue;
+			}
+			for (unsigned sample = 0; sample < samples; ++sample) {
+				rays.push_back(camera_ray(x, y, sample, img_plane_dist, trans_mat));
+			}
+			tile_pixels.emplace_back(x, y);
+		}
+	}
+	std::vector<HitPoint> hits;
+	std::vector<Color> traced_colors(tile_pixels.size());
+	trace_packets(rays, scene, hits);
+
+	for (unsigned i = 0; i < rays.size(); ++i) {
+		Pixel const& pixel = tile_pixels[i / samples];
+		traced_colors[i / samples] += shade_sample(rays[i], hits[i], scene, pixel.x, pixel.y, i % samples);
+		add_guide(guides_[pixel.y * width_ + pixel.x], hits[i], 1.0f / samples);
+	}
+	for (unsigned i = 0; i < tile_pixels.size(); ++i) {
+		tile_pixels[i].color = tone_map_color(traced_colors[i] * (1.0f / samples));
+		write(tile_pixels[i]);
+	}
+}
+
+//interpolates the missing pixels from the traced pixels around them that show the same surface
+void Renderer::reconstruct_rect(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
+	for (unsigned y = rect.min_y; y < rect.max_y; ++y) {
+		for (unsigned x = rect.min_x; x < rect.max_x; ++x) {
+			if (is_traced(x, y)) {
+				continue;
+			}
+			unsigned i = y * width_ + x;
+			Pixel pixel {x, y};
+			find_guide(x, y, scene, img_plane_dist, trans_mat);
+
+			//the previous checkerboard frame traced this pixel, its color stays valid as long as the surface is the same
+			if (previous_guides_.size() == guides_.size() && guides_match(guides_[i], previous_guides_[i])) {
+				pixel.color = color_buffer_[i];
+				write(pixel);
+				continue;
+			}
+			Color color_sum {};
+			float weight_sum = 0;
+
+			for (unsigned ny = y > 0 ? y - 1 : 0; ny <= std::min(y + 1, height_ - 1); ++ny) {
+				for (unsigned nx = x > 0 ? x - 1 : 0; nx <= std::min(x + 1, width_ - 1); ++nx) {
+					if (!is_traced(nx, ny)) {
+						continue;
+					}
+					unsigned neighbor = ny * width_ + nx;
+					//diagonal neighbors are further away, neighbors on other surfaces only count if there is nothing else
+					float weight = nx != x && ny != y ? 0.5f : 1;
+
+					if (!guides_match(guides_[i], guides_[neighbor])) {
+						weight *= 0.001f;
+					}
+					color_sum += color_buffer_[neighbor] * weight;
+					weight_sum += weight;
+				}
+			}
+			pixel.color = weight_sum > 0 ? color_sum * (1 / weight_sum) : Color {};
+			write(pixel);
+		}
+	}
+}
+
+//takes the surface of a missing pixel from its traced neighbors if they all show the same one, else traces a ray to find it
+void Renderer::find_guide(unsigned x, unsigned y, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat) {
+	GuideSample const* neighbor_guide = nullptr;
+	bool is_edge = false;
+
+	for (unsigned ny = y > 0 ? y - 1 : 0; ny <= std::min(y + 1, height_ - 1); ++ny) {
+		for (unsigned nx = x > 0 ? x - 1 : 0; nx <= std::min(x + 1, width_ - 1); ++nx) {
+			if (!is_traced(nx, ny)) {
+				continue;
+			}
+			GuideSample const& guide = guides_[ny * width_ + nx];
+
+			if (nullptr == neighbor_guide) {
+				neighbor_guide = &guide;
+			} else if (!guides_match(*neighbor_guide, guide)) {
+				is_edge = true;
+			}
+		}
+	}
+	if (nullptr != neighbor_guide && !is_edge) {
+		guides_[y * width_ + x] = *neighbor_guide;
+		return;
+	}
+	HitPoint hit = scene.root->intersect(camera_ray(x, y, 0, img_plane_dist, trans_mat));
+	add_guide(guides_[y * width_ + x], hit, 1);
+}
+
+//true if two pixels show the same surface, judged by the same tolerances as adaptive anti aliasing
+bool Renderer::guides_match(GuideSample const& guide, GuideSample const& other) const {
+	if ((0 == guide.depth) != (0 == other.depth)) {
+		return false;
+	}
+	float normal_lengths = glm::length(guide.normal) * glm::length(other.normal);
+	return 0 == guide.depth || (
+			std::abs(guide.depth - other.depth) <= AA_DEPTH_TOLERANCE * std::min(guide.depth, other.depth) &&
+			glm::dot(guide.normal, other.normal) >= AA_NORMAL_TOLERANCE * normal_lengths);
+}
+
+//true if the pixels show different objects, edges of the same object or a change of color that needs more samples
+bool Renderer::needs_refinement(PixelSample const& sample, PixelSample const& neighbor) const {
+	if (sample.does_intersect != neighbor.does_intersect) {
+		return true;
+	}
+	if (sample.does_intersect && (
+			sample.object_id != neighbor.object_id ||
+			std::abs(sample.distance - neighbor.distance) > AA_DEPTH_TOLERANCE * std::min(sample.distance, neighbor.distance) ||
+			glm::dot(sample.normal, neighbor.normal) < AA_NORMAL_TOLERANCE)) {
+		return true;
+	}
+	Color difference = tone_map_color(sample.color) - tone_map_color(neighbor.color);
+	return std::max(std::abs(difference.r), std::max(std::abs(difference.g), std::abs(difference.b))) > aa_color_tolerance_;
+}
+
 void Renderer::write(Pixel const& p) {
 	// flip pixels, because of opengl glDrawPixels
 	size_t buf_pos = (width_ * p.y + p.x);
@@ -105,12 +1235,38 @@ void Renderer::write(Pixel const& p) {
 	ppm_.write(p);
 }
 
-Color Renderer::trace(Ray const& ray, Scene const& scene, unsigned ray_bounces) const {
-	HitPoint closest_hit = scene.root->intersect(ray);
-	return closest_hit.does_intersect ? shade(closest_hit, scene, ray_bounces) : Color {};
+Color Renderer::trace(Ray const& ray, Scene const& scene, unsigned ray_bounces, Color const& path_weight) const {
+	float survival = survival_probability(path_weight);
+
+	if (0 == survival) {
+		return Color {};
+	}
+	//rays that survived the roulette stand in for the dropped ones and weigh more
+	return shade_closest_hit(ray, scene.root->intersect(ray), scene, ray_bounces, path_weight * (1 / survival)) * (1 / survival);
+}
+
+float Renderer::survival_probability(Color const& path_weight) const {
+	float max_weight = max_component(path_weight);
+
+	if (max_weight >= min_ray_weight_) {
+		return 1;
+	}
+	if (!russian_roulette_ || max_weight <= 0) {
+		return 0;
+	}
+	float survival = max_weight / min_ray_weight_;
+	return next_random() < survival ? survival : 0;
+}
+
+Color Renderer::shade_closest_hit(Ray const& ray, HitPoint closest_hit, Scene const& scene, unsigned ray_bounces, Color const& path_weight) const {
+	//keeps the footprint a shape chose its level of detail with, so rays leaving the hit point see the same surface
+	if (0 == closest_hit.footprint) {
+		closest_hit.footprint = ray.footprint(closest_hit.distance);
+	}
+	return closest_hit.does_intersect ? shade(closest_hit, scene, ray_bounces, path_weight) : Color {};
 }
 
-Color Renderer::shade(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces) const {
+Color Renderer::shade(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces, Color const& path_weight) const {
 	auto material = hit_point.hit_material;
 	Color shaded_color = phong_color(hit_point, scene) * material->opacity;
 
@@ -120,16 +1276,17 @@ Color Renderer::shade(HitPoint const& hit_point, Scene const& scene, unsigned ra
 	if (material->glossy > 0 && material->opacity < 1) {
 		float reflectance = schlick_reflection_ratio(hit_point.ray_direction, hit_point.surface_normal, material->ior);
 		shaded_color *= reflectance * material->opacity;
-		shaded_color += reflection(hit_point, scene, ray_bounces) * reflectance;
-		shaded_color += refraction(hit_point, scene, ray_bounces) * (1 - reflectance) * (1 - material->opacity);
+		float transmittance = (1 - reflectance) * (1 - material->opacity);
+		shaded_color += reflection(hit_point, scene, ray_bounces, path_weight * reflectance) * reflectance;
+		shaded_color += refraction(hit_point, scene, ray_bounces, path_weight * transmittance) * (1 - reflectance) * (1 - material->opacity);
 	} else if (material->glossy > 0) {
 		float reflectance = schlick_reflection_ratio(hit_point.ray_direction, hit_point.surface_normal, material->ior);
 		reflectance = material->glossy + (1 - material->glossy) * reflectance;
 		shaded_color *= 1 - reflectance;
-		shaded_color += reflection(hit_point, scene, ray_bounces) * reflectance;
+		shaded_color += reflection(hit_point, scene, ray_bounces, path_weight * reflectance) * reflectance;
 	} else if (material->opacity < 1) {
 		shaded_color *= material->opacity;
-		shaded_color += refraction(hit_point, scene, ray_bounces) * (1 - material->opacity);
+		shaded_color += refraction(hit_point, scene, ray_bounces, path_weight * (1 - material->opacity)) * (1 - material->opacity);
 	}
 	return shaded_color;
 }
@@ -143,9 +1300,9 @@ Color Renderer::phong_color(HitPoint const& hit_point, Scene const& scene) const
 		glm::vec3 light_dir = light.position - hit_point.position;
 		float distance = glm::length(light_dir);
 		light_dir = glm::normalize(light_dir);
-		Ray light_ray {hit_point.position, light_dir};
+		Ray light_ray {hit_point.position, light_dir, hit_point.footprint};
 
-		if (find_light_block(light_ray, distance, scene).does_intersect) {
+		if (find_light_block(light_ray, distance - light.radius, scene).does_intersect) {
 			continue;
 		}
 		glm::vec3 normal = hit_point.surface_normal;
@@ -154,12 +1311,13 @@ Color Renderer::phong_color(HitPoint const& hit_point, Scene const& scene) const
 		if (cos_view_angle < 0) {
 			continue;
 		}
+		Color intensity = incident_intensity(light, distance);
 		//adds diffuse light
-		phong_color += light.intensity * material->kd * cos_view_angle;
+		phong_color += intensity * material->kd * cos_view_angle;
 
 		//adds specular light
 		if (material->m != 0) {
-			phong_color += specular_color(hit_point.ray_direction, light_dir, normal, light.intensity, material);
+			phong_color += specular_color(hit_point.ray_direction, light_dir, normal, intensity, material);
 		}
 	}
 	return phong_color;
@@ -191,16 +1349,32 @@ Color Renderer::specular_color(
 	return light_intensity * material->ks * specular_factor;
 }
 
-Color Renderer::reflection(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces) const {
+Color Renderer::reflection(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces, Color const& path_weight) const {
+	Color const& ks = hit_point.hit_material->ks;
+	return trace(reflected_ray(hit_point), scene, ray_bounces + 1, path_weight * ks) * ks;
+}
+
+Color Renderer::refraction(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces, Color const& path_weight) const {
+	Ray new_ray;
+
+	//returns total reflection if critical angle is reached
+	if (!refracted_ray(hit_point, new_ray)) {
+		return reflection(hit_point, scene, ray_bounces, path_weight);
+	}
+	Color const& kd = hit_point.hit_material->kd;
+	return trace(new_ray, scene, ray_bounces + 1, path_weight * kd) * kd;
+}
+
+Ray Renderer::reflected_ray(HitPoint const& hit_point) const {
 	glm::vec3 ray_dir = hit_point.ray_direction;
 	glm::vec3 normal = hit_point.surface_normal;
 
 	float cos_incoming = -glm::dot(normal, ray_dir);
 	glm::vec3 new_dir = ray_dir + (normal * cos_incoming * 2.0f);
-	return trace({hit_point.position, new_dir}, scene, ray_bounces + 1) * hit_point.hit_material->ks;
+	return {hit_point.position, new_dir, hit_point.footprint, cone_spread_};
 }
 
-Color Renderer::refraction(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces) const {
+bool Renderer::refracted_ray(HitPoint const& hit_point, Ray& refracted) const {
 	glm::vec3 ray_dir = hit_point.ray_direction;
 	glm::vec3 normal = hit_point.surface_normal;
 	float eta = 1 / hit_point.hit_material->ior;
@@ -213,15 +1387,13 @@ Color Renderer::refraction(HitPoint const& hit_point, Scene const& scene, unsign
 	}
 	float cos_outgoing_squared = 1 - eta * eta * (1 - cos_incoming * cos_incoming);
 
-	//returns total reflection if critical angle is reached
 	if (cos_outgoing_squared < 0) {
-		return reflection(hit_point, scene, ray_bounces);
-	}else {
-		//glm::vec3 new_dir = glm::refract(ray_dir, normal, eta);
-		glm::vec3 new_dir = ray_dir * eta + normal * (eta * cos_incoming - sqrtf(cos_outgoing_squared));
-		Ray new_ray {hit_point.position - normal * (2 * EPSILON), new_dir};
-		return trace(new_ray, scene, ray_bounces + 1) * hit_point.hit_material->kd;
+		return false;
 	}
+	//glm::vec3 new_dir = glm::refract(ray_dir, normal, eta);
+	glm::vec3 new_dir = ray_dir * eta + normal * (eta * cos_incoming - sqrtf(cos_outgoing_squared));
+	refracted = {hit_point.position - normal * (2 * EPSILON), new_dir, hit_point.footprint, cone_spread_};
+	return true;
 }
 
 //https://en.wikipedia.org/wiki/Fresnel_equations
@@ -275,6 +1447,242 @@ float Renderer::schlick_reflection_ratio(glm::vec3 const& ray_dir, glm::vec3 con
 	return ratio;
 }
 
+//paths with fewer bounces are never ended by Russian roulette
+#define PATH_MIN_BOUNCES 3
+
+Color Renderer::shade_sample(Ray const& ray, HitPoint const& hit, Scene const& scene, unsigned x, unsigned y, unsigned sample) const {
+	seed_random(x, y, sample, frame_);
+
+	if (Integrator::path_tracing == integrator_) {
+		return trace_path(ray, hit, scene, x, y, sample);
+	}
+	return shade_closest_hit(ray, hit, scene);
+}
+
+//distance along the ray to the sphere of a light, infinity if it misses or the light is a point
+float light_distance(Ray const& ray, PointLight const& light) {
+	if (light.radius <= 0) {
+		return std::numeric_limits<float>::infinity();
+	}
+	glm::vec3 to_origin = ray.origin - light.position;
+	float a = glm::dot(ray.direction, ray.direction);
+	float b = glm::dot(to_origin, ray.direction);
+	float c = glm::dot(to_origin, to_origin) - light.radius * light.radius;
+	float discriminant = b * b - a * c;
+
+	if (discriminant < 0) {
+		return std::numeric_limits<float>::infinity();
+	}
+	float root = std::sqrt(discriminant);
+	float t = (-b - root) / a;
+
+	if (t <= EPSILON) {
+		t = (-b + root) / a;
+	}
+	return t > EPSILON ? t : std::numeric_limits<float>::infinity();
+}
+
+//one minus the cosine of the half opening angle of the cone from the point that encloses the sphere of the light,
+//written as sin² / (1 + cos) so small and distant lights do not round it to zero
+float light_cone_height(glm::vec3 const& point, PointLight const& light) {
+	float sin_squared = std::min(1.0f, light.radius * light.radius / glm::dot(light.position - point, light.position - point));
+	return sin_squared / (1 + std::sqrt(1 - sin_squared));
+}
+
+//https://www.pbr-book.org/3ed-2018/Monte_Carlo_Integration/Importance_Sampling#MultipleImportanceSampling
+float power_heuristic(float pdf, float other_pdf) {
+	return pdf * pdf / (pdf * pdf + other_pdf * other_pdf);
+}
+
+//direction around an axis inside the cone with the given light_cone_height, uniformly distributed over the solid angle
+glm::vec3 sample_cone(glm::vec3 const& axis, float cone_height, glm::vec2 const& sample) {
+	float cos_theta = 1 - sample.x * cone_height;
+	float sin_theta = std::sqrt(std::max(0.0f, 1 - cos_theta * cos_theta));
+	float phi = 2 * PI * sample.y;
+	glm::vec3 tangent = glm::normalize(glm::cross(std::abs(axis.x) > 0.5f ? glm::vec3 {0, 1, 0} : glm::vec3 {1, 0, 0}, axis));
+	glm::vec3 bitangent = glm::cross(axis, tangent);
+	return glm::normalize(tangent * (sin_theta * std::cos(phi)) + bitangent * (sin_theta * std::sin(phi)) + axis * cos_theta);
+}
+
+//direction around the normal that is more likely the more it faces along the normal, with a pdf of cos / pi
+glm::vec3 sample_cosine(glm::vec3 const& normal, glm::vec2 const& sample) {
+	float radius = std::sqrt(sample.x);
+	float phi = 2 * PI * sample.y;
+	glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.x) > 0.5f ? glm::vec3 {0, 1, 0} : glm::vec3 {1, 0, 0}, normal));
+	glm::vec3 bitangent = glm::cross(normal, tangent);
+	float height = std::sqrt(std::max(0.0f, 1 - sample.x));
+	return glm::normalize(tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) + normal * height);
+}
+
+Color Renderer::trace_path(Ray ray, HitPoint hit, Scene const& scene, unsigned x, unsigned y, unsigned sample) const {
+	Color radiance {};
+	Color throughput {1, 1, 1};
+	//pdf of the direction of the ray if it bounced off a diffuse surface, 0 for camera rays and perfect reflections
+	float direction_pdf = 0;
+
+	for (unsigned bounce = 0; ; ++bounce) {
+		//adds the light of a light sphere in front of the surface, weighted against having sampled it directly
+		PointLight const* hit_light = nullptr;
+		float closest_t = hit.does_intersect ? hit.distance : std::numeric_limits<float>::infinity();
+
+		for (PointLight const& light : scene.lights) {
+			float t = light_distance(ray, light);
+
+			if (t < closest_t) {
+				closest_t = t;
+				hit_light = &light;
+			}
+		}
+		if (nullptr != hit_light) {
+			float weight = 1;
+
+			if (direction_pdf > 0) {
+				float light_pdf = 1 / (2 * PI * light_cone_height(ray.origin, *hit_light));
+				weight = power_heuristic(direction_pdf, light_pdf);
+			}
+			radiance += throughput * hit_light->intensity * (weight / (hit_light->radius * hit_light->radius));
+			break;
+		}
+		//the light bouncing between surfaces replaces the ambient light of Phong shading, so the background stays dark
+		if (!hit.does_intersect) {
+			break;
+		}
+		if (0 == hit.footprint) {
+			hit.footprint = ray.footprint(hit.distance);
+		}
+		auto material = hit.hit_material;
+		glm::vec3 normal = glm::dot(hit.surface_normal, ray.direction) > 0 ? -hit.surface_normal : hit.surface_normal;
+		//splits the light into the same shares as shade()
+		float diffuse_share = material->opacity;
+		float reflection_share = 0;
+		float refraction_share = 0;
+
+		if (material->glossy > 0 && material->opacity < 1) {
+			float reflectance = schlick_reflection_ratio(hit.ray_direction, hit.surface_normal, material->ior);
+			diffuse_share *= reflectance * material->opacity;
+			reflection_share = reflectance;
+			refraction_share = (1 - reflectance) * (1 - material->opacity);
+		} else if (material->glossy > 0) {
+			float reflectance = schlick_reflection_ratio(hit.ray_direction, hit.surface_normal, material->ior);
+			reflection_share = material->glossy + (1 - material->glossy) * reflectance;
+			diffuse_share *= 1 - reflection_share;
+		} else if (material->opacity < 1) {
+			diffuse_share *= material->opacity;
+			refraction_share = 1 - material->opacity;
+		}
+		float share_sum = diffuse_share + reflection_share + refraction_share;
+		bool can_bounce = bounce < max_ray_bounces_ && share_sum > 0;
+		//chance that the next ray bounces off diffusely, which is the other way to find the light of light spheres
+		float diffuse_chance = can_bounce ? diffuse_share / share_sum : 0;
+
+		if (diffuse_share > 0) {
+			glm::vec2 light_sample = sampler_->sample(x, y, sample, 3 * bounce + 1, frame_);
+			radiance += throughput * direct_light(hit, normal, scene, light_sample, diffuse_chance) * diffuse_share;
+		}
+		if (!can_bounce) {
+			break;
+		}
+		glm::vec2 choice = sampler_->sample(x, y, sample, 3 * bounce + 2, frame_);
+
+		//ends long paths by chance and lets the surviving ones carry the light of the ended ones
+		if (bounce >= PATH_MIN_BOUNCES) {
+			float survival = std::min(1.0f, max_component(throughput) * share_sum);
+
+			if (choice.y >= survival) {
+				break;
+			}
+			throughput *= 1 / survival;
+		}
+		float pick = choice.x * share_sum;
+		throughput *= share_sum;
+
+		if (pick < diffuse_share) {
+			glm::vec3 direction = sample_cosine(normal, sampler_->sample(x, y, sample, 3 * bounce + 3, frame_));
+			ray = {hit.position, direction, hit.footprint, cone_spread_};
+			throughput *= material->kd;
+			direction_pdf = glm::dot(normal, direction) / PI * diffuse_chance;
+		} else if (pick < diffuse_share + reflection_share || !refracted_ray(hit, ray)) {
+			ray = reflected_ray(hit);
+			throughput *= material->ks;
+			direction_pdf = 0;
+		} else {
+			throughput *= material->kd;
+			direction_pdf = 0;
+		}
+		if (is_black(throughput)) {
+			break;
+		}
+		hit = scene.root->intersect(ray);
+	}
+	return radiance;
+}
+
+/**
+ * Light arriving directly from the lights that the surface reflects diffusely or as Phong highlight towards the ray.
+ * @param diffuse_chance chance of bouncing off diffusely next, which weighs light spheres against finding them by bouncing
+ */
+Color Renderer::direct_light(HitPoint const& hit_point, glm::vec3 const& normal, Scene const& scene, glm::vec2 const& light_sample,
+                             float diffuse_chance) const {
+	auto material = hit_point.hit_material;
+	Color light_sum {};
+
+	for (PointLight const& light : scene.lights) {
+		glm::vec3 light_dir;
+		float distance;
+		float light_pdf = 0;
+
+		if (light.radius > 0) {
+			glm::vec3 to_light = light.position - hit_point.position;
+
+			if (glm::length(to_light) <= light.radius) {
+				continue;
+			}
+			float cone_height = light_cone_height(hit_point.position, light);
+			light_dir = sample_cone(glm::normalize(to_light), cone_height, light_sample);
+			distance = light_distance({hit_point.position, light_dir}, light);
+			light_pdf = 1 / (2 * PI * cone_height);
+
+			//directions in the cone always hit the sphere, only rounding lets them pass the edge of a tiny one
+			if (std::isinf(distance)) {
+				distance = glm::length(to_light) - light.radius;
+			}
+		} else {
+			light_dir = light.position - hit_point.position;
+			distance = glm::length(light_dir);
+			light_dir = glm::normalize(light_dir);
+		}
+		float cos_view_angle = glm::dot(normal, light_dir);
+
+		if (cos_view_angle <= 0 || find_light_block({hit_point.position, light_dir, hit_point.footprint}, distance - EPSILON, scene).does_intersect) {
+			continue;
+		}
+		//a light sphere far away covers π r² / d² of the sky with a radiance of intensity / r²,
+		//so a point light gives π times its incident intensity as irradiance, which the kd/π BRDF reflects as kd times it
+		if (light.radius <= 0) {
+			Color intensity = incident_intensity(light, distance);
+			Color irradiance = intensity * (PI * cos_view_angle);
+			light_sum += irradiance * material->kd * (1 / PI);
+
+			if (material->m != 0) {
+				light_sum += specular_color(hit_point.ray_direction, light_dir, normal, intensity, material);
+			}
+			continue;
+		}
+		//diffuse light can also be found by bouncing off, the Phong highlight only by sampling the light
+		float diffuse_pdf = cos_view_angle / PI * diffuse_chance;
+		Color radiance = light.intensity * (1 / (light.radius * light.radius));
+		Color reflected = material->kd * (power_heuristic(light_pdf, diffuse_pdf) / PI);
+
+		if (material->m != 0) {
+			glm::vec3 reflection_dir = 2 * cos_view_angle * normal - light_dir;
+			float cos_specular_angle = std::max(0.0f, glm::dot(reflection_dir, -hit_point.ray_direction));
+			reflected += material->ks * ((material->m + 2) / (2 * PI) * std::pow(cos_specular_angle, material->m));
+		}
+		light_sum += radiance * reflected * (cos_view_angle / light_pdf);
+	}
+	return light_sum;
+}
+
 Color Renderer::normal_color(HitPoint const& hit_point) const {
 	return Color {
 			(hit_point.surface_normal.x + 1) / 2,
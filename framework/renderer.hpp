@@ -14,18 +14,176 @@
 #include <glm/glm.hpp>
 #include <atomic>
 #include <thread>
+#include <mutex>
 #include "color.hpp"
 #include "pixel.hpp"
 #include "ppmwriter.hpp"
 #include "scene.hpp"
+#include "threadPool.hpp"
+#include "rayQueue.hpp"
+#include "sampler.hpp"
+#include "denoiser.hpp"
+#include "renderJob.hpp"
+#include "checkpoint.hpp"
+
+//first sample of a pixel that adaptive anti aliasing compares with the samples of the neighboring pixels
+struct PixelSample {
+	Color color {};
+	bool does_intersect = false;
+	float distance = 0;
+	glm::vec3 normal {};
+	//hash of the name of the hit object
+	std::size_t object_id = 0;
+	Color albedo {};
+};
+
+//conditions that end progressive rendering, whichever is met first
+struct ProgressiveStop {
+	//seconds after which no further pass is started, 0 for no limit
+	double time_budget = 0;
+	//samples per pixel, 0 for no limit
+	unsigned max_samples = 0;
+	//mean standard error of the pixel brightnesses that counts as converged, 0 for no target
+	float noise_target = 0;
+};
+
+//how the light that arrives through a camera ray is found
+enum class Integrator {
+	//Phong shading with perfect reflections and refractions
+	whitted,
+	//Monte Carlo path tracing with light sampling, diffuse bounces and Russian roulette
+	path_tracing
+};
+
+//order in which the rays of an image tile are traced
+enum class RenderMode {
+	//traces every camera ray and its reflections and refractions to the end before the next one
+	recursive,
+	//traces all rays of the tile with the same amount of bounces together, stage by stage
+	wavefront,
+	//wavefront that sorts the reflected and refracted rays of each wave before tracing them
+	sorted_wavefront
+};
+
+//which pixels of an image get traced, the others are filled in from their traced neighbors
+enum class PixelPattern {
+	//traces every pixel
+	full,
+	//traces every second pixel of every second row
+	half_resolution,
+	//traces every second pixel of each row, alternating between the two halves by the number of the frame
+	checkerboard
+};
 
 class Renderer {
 public:
-	Renderer(unsigned w, unsigned h, std::string const& file, unsigned aa_steps, unsigned max_ray_bounces);
+	/**
+	 * @param tile_size width and height of the square image tiles the threads take turns rendering
+	 * @param mode order in which the rays of each tile are traced
+	 */
+	Renderer(unsigned w, unsigned h, std::string const& file, unsigned aa_steps, unsigned max_ray_bounces,
+	         unsigned tile_size = 16, RenderMode mode = RenderMode::recursive);
 
 	void render(Scene const& scene);
+	/**
+	 * Traces only the pixels inside the regions and keeps the rest of the image as it was,
+	 * so small changes can be rendered into an image rendered before or loaded with load_image.
+	 */
+	void render(Scene const& scene, std::vector<PixelRect> const& regions);
+	/**
+	 * Traces the pixels inside the rectangle into the color buffer and nothing else, the image is not saved.
+	 * Adaptive anti aliasing, reduced pixel patterns, denoising and checkpoints need the whole image and are left out,
+	 * which lets workers of a distributed render trace the tiles they are sent.
+	 */
+	void render_rect(Scene const& scene, PixelRect const& rect);
+	/**
+	 * Starts rendering on a thread of its own and returns right away.
+	 * A renderer runs one render at a time: further renders, synchronous or not, wait until the job is finished,
+	 * so callbacks of the job must not render with the same renderer. Settings must not change while the job runs.
+	 * @return handle to follow, wait for or cancel the render
+	 */
+	std::shared_ptr<RenderJob> render_async(Scene const& scene, RenderCallbacks callbacks = {});
+	std::shared_ptr<RenderJob> render_async(Scene const& scene, std::vector<PixelRect> const& regions, RenderCallbacks callbacks = {});
+	/**
+	 * Renders passes of one sample per pixel and averages them until a stop condition is met.
+	 * The color buffer holds the estimate of all passes so far after each pass.
+	 * Without any stop condition it renders as many passes as the anti aliasing grid has samples.
+	 * The default grid sampler repeats its positions after that, other samplers keep adding new ones.
+	 * Runs on the calling thread and cannot be cancelled, only the stop conditions end it.
+	 */
+	void render_progressive(Scene const& scene, ProgressiveStop const& stop);
+	//samples per pixel rendered so far by progressive rendering
+	unsigned sample_count() const;
+	//mean standard error of the pixel brightnesses after the last progressive pass
+	float noise() const;
+	/**
+	 * Stops tracing reflections and refractions that add too little to their pixel.
+	 * @param min_weight share of a sample below which a ray is not traced, 0 traces all rays
+	 * @param russian_roulette keeps tracing weak rays by chance and brightens the ones that survive, which removes the bias of dropping them
+	 */
+	void set_pruning(float min_weight, bool russian_roulette = false);
+	/**
+	 * Path tracing takes its random numbers from the sampler and bounces at most max_ray_bounces times.
+	 * Only the recursive, adaptive and progressive rendering trace paths, wavefronts always use Phong shading.
+	 */
+	void set_integrator(Integrator integrator);
+	/**
+	 * Sets where in their pixels the camera rays go through, a regular grid of aa_steps² samples by default.
+	 */
+	void set_sampler(std::shared_ptr<Sampler const> sampler);
+	/**
+	 * Traces one sample per pixel first and only traces the full anti aliasing grid where neighboring pixels differ.
+	 * Only the recursive mode samples adaptively.
+	 * @param color_tolerance largest difference of a color channel between neighbors that is not refined
+	 */
+	void set_adaptive_aa(bool is_adaptive, float color_tolerance = 0.03f);
+	/**
+	 * Records the normals, depths and albedos of the surfaces seen by the camera rays while rendering
+	 * and filters the noise of the image with them before it is saved.
+	 */
+	void set_denoising(bool is_denoising, DenoiseOptions const& options = {});
+	/**
+	 * Traces only some pixels fully, the missing pixels are interpolated from the neighbors that show the same surface.
+	 * A missing pixel only gets a ray that finds its depth and normal if its traced neighbors show different surfaces,
+	 * so thin objects that fall between the traced pixels can disappear.
+	 * Checkerboard frames keep the pixels of the previous frame where the surface has not changed.
+	 * Only the recursive mode without adaptive anti aliasing renders reduced patterns.
+	 */
+	void set_pixel_pattern(PixelPattern pattern);
+	/**
+	 * Saves the finished tiles or progressive passes to the file while rendering and when a render is cancelled.
+	 * A render that finds a checkpoint of the same image size, tiles, scene, sampler, integrator, render mode,
+	 * bounces and frame in the file continues it.
+	 * The file is removed once the render is complete.
+	 * @param file path of the checkpoint, empty to render without checkpoints
+	 * @param interval seconds between two checkpoints
+	 */
+	void set_checkpoint(std::string const& file, double interval = 60);
+	/**
+	 * Sets the number of the image in an animation. All random numbers are seeded from the pixel, the sample and the frame,
+	 * so a frame renders the same with any amount of threads and in any tile order.
+	 * The checkerboard pattern picks its half by the frame, so the frame has to change between renders to trace the other half.
+	 */
+	void set_frame(unsigned frame);
+	//sets the file the image is saved to, so one renderer can save the frames of an animation
+	void set_file(std::string const& file);
 	void write(Pixel const& p);
+	/**
+	 * Fills the image with a PPM file written by this renderer before, for example to render regions into it
+	 * @return false if the file cannot be read or its size differs from the image
+	 */
+	bool load_image(std::string const& file);
+	//writes the image to the file given to the constructor
+	void save();
+	//saves the pixels inside the rectangle as an image of their own
+	void save_crop(std::string const& file, PixelRect const& rect) const;
 
+	inline unsigned width() const {
+		return width_;
+	}
+	inline unsigned height() const {
+		return height_;
+	}
 	inline std::vector<Color> const& color_buffer() const {
 		return color_buffer_;
 	}
@@ -37,17 +195,109 @@ private:
 	std::vector<Color> color_buffer_;
 	std::string filename_;
 	PpmWriter ppm_;
+	//sums of all progressive samples of each pixel
+	std::vector<Color> accumulation_;
+	//sums of the tone mapped brightnesses and their squares, which tell how much the samples of a pixel vary
+	std::vector<float> brightness_sums_;
+	std::vector<float> brightness_squares_;
+	std::atomic<unsigned> sample_count_;
+	std::atomic<float> noise_;
 
 	unsigned aa_steps_;
 	unsigned max_ray_bounces_;
+	//growth of the ray cone width per distance for camera and secondary rays
+	float cone_spread_;
+
+	unsigned tile_size_;
+	std::shared_ptr<Sampler const> sampler_;
+	//tile indices in the order they are handed out to the threads
+	std::vector<unsigned> tile_order_;
+	RenderMode mode_;
+	float min_ray_weight_;
+	bool russian_roulette_;
+	bool is_adaptive_aa_;
+	float aa_color_tolerance_;
+	Integrator integrator_;
+	bool is_denoising_;
+	DenoiseOptions denoise_options_;
+	//surfaces seen through each pixel, only recorded when denoising or rendering reduced patterns
+	std::vector<GuideSample> guides_;
+	PixelPattern pixel_pattern_;
+	//number of the image in an animation
+	unsigned frame_;
+	//surfaces of the previous checkerboard frame
+	std::vector<GuideSample> previous_guides_;
+	std::string checkpoint_file_;
+	double checkpoint_interval_;
+	//held by every render, which all write the buffers and the ray cone spread of the renderer
+	std::mutex render_mutex_;
+	float prepare_camera(Camera const& cam, glm::mat4& trans_mat);
+	std::vector<PixelRect> tile_rects(std::vector<PixelRect> const& regions) const;
+	void render_regions(Scene const& scene, std::vector<PixelRect> const& regions, RenderJob& job);
+	//empty checkpoint with the settings of a render of the scene
+	Checkpoint make_checkpoint(Scene const& scene, std::vector<PixelRect> const& rects) const;
+	bool resume_tiles(Checkpoint const& expected, std::vector<std::atomic<bool>>& finished_tiles);
+	//copies the pixels of a finished tile into the checkpoint, which is only read by saving while no tile is copied
+	void copy_tile(unsigned tile, PixelRect const& rect, Checkpoint& checkpoint) const;
+	void save_tiles(Checkpoint const& checkpoint) const;
+	bool resume_passes(Checkpoint const& expected);
+	void save_passes(Checkpoint checkpoint) const;
+	void render_tile(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	void render_block(unsigned min_x, unsigned min_y, unsigned max_x, unsigned max_y, Scene const& scene,
+	                  float img_plane_dist, glm::mat4 const& trans_mat, std::vector<Pixel>& pixels,
+	                  std::vector<GuideSample>& guides) const;
+	Ray camera_ray(unsigned x, unsigned y, unsigned sample, float img_plane_dist, glm::mat4 const& trans_mat) const;
+	void trace_packets(std::vector<Ray> const& rays, Scene const& scene, std::vector<HitPoint>& hits) const;
+
+	bool is_traced(unsigned x, unsigned y) const;
+	void render_tile_reduced(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	void reconstruct_rect(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	void find_guide(unsigned x, unsigned y, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	bool guides_match(GuideSample const& guide, GuideSample const& other) const;
+
+	void sample_tile(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat,
+	                 std::vector<PixelSample>& first_samples) const;
+	void render_tile_adaptive(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat,
+	                          std::vector<PixelSample> const& first_samples);
+	bool needs_refinement(PixelSample const& sample, PixelSample const& neighbor) const;
+
+	void render_pass_tile(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	float estimate_noise() const;
+	void denoise_image(std::vector<PixelRect> const& rects);
+
+	void render_tile_wavefront(PixelRect const& rect, Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	void extend(RayQueue const& rays, Scene const& scene, std::vector<HitPoint>& hits) const;
+	void shade_wave(PixelRect const& rect, RayQueue const& rays, std::vector<HitPoint>& hits, Scene const& scene, unsigned ray_bounces,
+	                std::vector<Color>& colors, ShadowQueue& shadows, RayQueue& next_rays) const;
+	void queue_direct_light(HitPoint const& hit_point, Color const& weight, unsigned pixel, Scene const& scene,
+	                        std::vector<Color>& colors, ShadowQueue& shadows) const;
+	void queue_ray(Ray const& ray, Color const& weight, unsigned pixel, unsigned path, RayQueue& next_rays) const;
+	void queue_reflection(HitPoint const& hit_point, Color const& weight, unsigned pixel, unsigned path,
+	                      RayQueue& next_rays) const;
+	void queue_refraction(HitPoint const& hit_point, Color const& weight, unsigned pixel, unsigned path,
+	                      RayQueue& next_rays) const;
+	void trace_shadows(ShadowQueue const& shadows, Scene const& scene, std::vector<Color>& colors) const;
 
-	std::atomic_uint pixel_index_;
-	void thread_function(Scene const& scene, float img_plane_dist, glm::mat4 const& trans_mat);
+	/**
+	 * Shades the first hit of a camera ray with the selected integrator
+	 * @param sample number of the sample in the pixel, which seeds the random numbers of the path
+	 */
+	Color shade_sample(Ray const& ray, HitPoint const& hit, Scene const& scene, unsigned x, unsigned y, unsigned sample) const;
+	Color trace_path(Ray ray, HitPoint hit, Scene const& scene, unsigned x, unsigned y, unsigned sample) const;
+	Color direct_light(HitPoint const& hit_point, glm::vec3 const& normal, Scene const& scene, glm::vec2 const& light_sample,
+	                   float diffuse_chance) const;
 
-	Color trace(Ray const& ray, Scene const& scene, unsigned ray_bounces = 0) const;
+	/**
+	 * @param path_weight share of the traced light that reaches the pixel
+	 */
+	Color trace(Ray const& ray, Scene const& scene, unsigned ray_bounces = 0, Color const& path_weight = {1, 1, 1}) const;
+	Color shade_closest_hit(Ray const& ray, HitPoint closest_hit, Scene const& scene, unsigned ray_bounces = 0,
+	                        Color const& path_weight = {1, 1, 1}) const;
+	//chance that a ray with the weight gets traced, 0 drops it
+	float survival_probability(Color const& path_weight) const;
 	HitPoint find_light_block(Ray const& light_ray, float range, Scene const& scene) const;
 
-	Color shade(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces = 0) const;
+	Color shade(HitPoint const& hit_point, Scene const& scene, unsigned ray_bounces = 0, Color const& path_weight = {1, 1, 1}) const;
 	Color phong_color(HitPoint const& hitPoint, Scene const& scene) const;
 	Color specular_color(glm::vec3 const& viewer_dir, glm::vec3 const& light_dir, glm::vec3 const& normal,
 	                     Color const& light_intensity, std::shared_ptr<Material> material) const;
@@ -55,8 +305,11 @@ private:
 	Color normal_color(HitPoint const& hitPoint) const;
 	Color tone_map_color(Color color) const;
 
-	Color reflection(HitPoint const& hitPoint, Scene const& scene, unsigned bounces) const;
-	Color refraction(const HitPoint &hit_point, const Scene &scene, unsigned int ray_bounces) const;
+	Color reflection(HitPoint const& hitPoint, Scene const& scene, unsigned bounces, Color const& path_weight) const;
+	Color refraction(const HitPoint &hit_point, const Scene &scene, unsigned int ray_bounces, Color const& path_weight) const;
+	Ray reflected_ray(HitPoint const& hit_point) const;
+	//returns false on total internal reflection
+	bool refracted_ray(HitPoint const& hit_point, Ray& refracted) const;
 	float fresnel_reflection_ratio(glm::vec3 const& ray_dir, glm::vec3 const& normal, float const& ior) const;
 	float schlick_reflection_ratio(glm::vec3 const& ray_dir, glm::vec3 const& normal, float const& ior) const;
 };
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <limits>
+#include "sampler.hpp"
+
+//width and height of the blue noise mask in pixels
+#define BLUE_NOISE_SIZE 64
+//spread of the energy each point of the mask puts on its surroundings while the mask is built
+#define BLUE_NOISE_SIGMA 1.5f
+
+//bases of the Halton sequence for pairs of dimensions
+static unsigned const HALTON_BASES[] {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+static unsigned const HALTON_DIMENSIONS = sizeof(HALTON_BASES) / sizeof(unsigned) / 2;
+
+//https://nullprogram.com/blog/2018/07/31/
+uint32_t hash_bits(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+uint32_t hash_bits(uint32_t a, uint32_t b, uint32_t c) {
+	return hash_bits(a ^ hash_bits(b ^ hash_bits(c)));
+}
+
+//https://en.wikipedia.org/wiki/Halton_sequence
+float radical_inverse(unsigned index, unsigned base) {
+	float inverse = 0;
+	float digit_value = 1.0f / base;
+
+	for (; index > 0; index /= base) {
+		inverse += (index % base) * digit_value;
+		digit_value /= base;
+	}
+	return inverse;
+}
+
+float to_unit_float(uint32_t bits) {
+	return (bits >> 8) * (1.0f / (1 << 24));
+}
+
+float wrap_unit(float value) {
+	return value - std::floor(value);
+}
+
+//seed of a dimension in a frame, the first frame keeps the dimension as it is because hash_bits(0) is 0
+uint32_t frame_seed(unsigned dimension, unsigned frame) {
+	return dimension ^ hash_bits(frame);
+}
+
+uint32_t reverse_bits(uint32_t bits) {
+	bits = (bits << 16) | (bits >> 16);
+	bits = ((bits & 0x00ff00ff) << 8) | ((bits & 0xff00ff00) >> 8);
+	bits = ((bits & 0x0f0f0f0f) << 4) | ((bits & 0xf0f0f0f0) >> 4);
+	bits = ((bits & 0x33333333) << 2) | ((bits & 0xcccccccc) >> 2);
+	bits = ((bits & 0x55555555) << 1) | ((bits & 0xaaaaaaaa) >> 1);
+	return bits;
+}
+
+//second dimension of the Sobol sequence, together with the reversed bits of the index it forms a (0,2) sequence
+//http://gruenschloss.org/sample-enum/sample-enum-src.zip
+uint32_t sobol_second_dimension(uint32_t index) {
+	uint32_t bits = 0;
+
+	for (uint32_t direction = 1u << 31; index > 0; index >>= 1, direction ^= direction >> 1) {
+		if (index & 1) {
+			bits ^= direction;
+		}
+	}
+	return bits;
+}
+
+//permutes the indices so aligned blocks of 2^k samples stay together, which keeps the first 2^k samples of a (0,2) sequence stratified
+//https://jcgt.org/published/0009/04/01/
+uint32_t shuffle_index(uint32_t index, uint32_t seed) {
+	index = reverse_bits(index);
+	index += seed;
+	index ^= index * 0x6c50b47c;
+	index ^= index * 0xb82f1e52;
+	index ^= index * 0xc7afe638;
+	index ^= index * 0x8d22f6e6;
+	return reverse_bits(index);
+}
+
+GridSampler::GridSampler(unsigned grid_size) :
+	grid_size_{std::max(1u, grid_size)} {}
+
+glm::vec2 GridSampler::sample(unsigned x, unsigned y, unsigned index, unsigned dimension, unsigned frame) const {
+	//the same grid in every dimension would make lights and bounces depend on the position in the pixel
+	if (dimension > 0) {
+		uint32_t bits = hash_bits(x, y, hash_bits(index, frame_seed(dimension, frame), 0));
+		return {to_unit_float(bits), to_unit_float(hash_bits(bits))};
+	}
+	index %= grid_size_ * grid_size_;
+	float cell_size = 1.0f / grid_size_;
+	return {(index / grid_size_) * cell_size, (index % grid_size_) * cell_size};
+}
+
+StratifiedSampler::StratifiedSampler(unsigned grid_size) :
+	grid_size_{std::max(1u, grid_size)} {}
+
+glm::vec2 StratifiedSampler::sample(unsigned x, unsigned y, unsigned index, unsigned dimension, unsigned frame) const {
+	unsigned cell = index % (grid_size_ * grid_size_);
+	uint32_t jitter = hash_bits(x, y, hash_bits(index, frame_seed(dimension, frame), 0));
+	float cell_size = 1.0f / grid_size_;
+	return {
+			(cell / grid_size_ + to_unit_float(jitter)) * cell_size,
+			(cell % grid_size_ + to_unit_float(hash_bits(jitter))) * cell_size};
+}
+
+glm::vec2 HaltonSampler::sample(unsigned x, unsigned y, unsigned index, unsigned dimension, unsigned frame) const {
+	unsigned bases = dimension % HALTON_DIMENSIONS;
+	//shifts the sequence of every pixel and dimension differently, so neighboring pixels do not repeat the same error
+	uint32_t shift = hash_bits(x, y, frame_seed(dimension, frame));
+	return {
+			wrap_unit(radical_inverse(index, HALTON_BASES[2 * bases]) + to_unit_float(shift)),
+			wrap_unit(radical_inverse(index, HALTON_BASES[2 * bases + 1]) + to_unit_float(hash_bits(shift)))};
+}
+
+glm::vec2 SobolSampler::sample(unsigned x, unsigned y, unsigned index, unsigned dimension, unsigned frame) const {
+	//flipping the same bits of all samples keeps the strata of the sequence intact
+	uint32_t scramble = hash_bits(x, y, frame_seed(dimension, frame));
+	//shuffles the order of the samples in the other dimensions, so their points are not paired with the same points of dimension 0
+	if (dimension > 0) {
+		index = shuffle_index(index, hash_bits(scramble, x, y));
+	}
+	return {
+			to_unit_float(reverse_bits(index) ^ scramble),
+			to_unit_float(sobol_second_dimension(index) ^ hash_bits(scramble))};
+}
+
+//ranks the pixels of the mask by filling the largest void left by the previous ones
+//https://en.wikipedia.org/wiki/Ordered_dithering#Void_and_cluster
+BlueNoiseSampler::BlueNoiseSampler() :
+	mask_(BLUE_NOISE_SIZE * BLUE_NOISE_SIZE) {
+	unsigned pixel_count = mask_.size();
+	std::vector<float> kernel(pixel_count);
+	std::vector<float> energy(pixel_count);
+	std::vector<bool> is_ranked(pixel_count, false);
+
+	//energy a point puts on pixels at each offset, wrapped around the borders of the mask
+	for (int y = 0; y < BLUE_NOISE_SIZE; ++y) {
+		for (int x = 0; x < BLUE_NOISE_SIZE; ++x) {
+			int dx = std::min(x, BLUE_NOISE_SIZE - x);
+			int dy = std::min(y, BLUE_NOISE_SIZE - y);
+			kernel[y * BLUE_NOISE_SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2 * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+		}
+	}
+	//tiny random energies break ties between equally empty pixels without a visible pattern
+	for (unsigned i = 0; i < pixel_count; ++i) {
+		energy[i] = to_unit_float(hash_bits(i)) * 1e-4f;
+	}
+	for (unsigned rank = 0; rank < pixel_count; ++rank) {
+		unsigned emptiest = 0;
+		float min_energy = std::numeric_limits<float>::infinity();
+
+		for (unsigned i = 0; i < pixel_count; ++i) {
+			if (!is_ranked[i] && energy[i] < min_energy) {
+				min_energy = energy[i];
+				emptiest = i;
+			}
+		}
+		is_ranked[emptiest] = true;
+		mask_[emptiest] = (rank + 0.5f) / pixel_count;
+		int point_x = emptiest % BLUE_NOISE_SIZE;
+		int point_y = emptiest / BLUE_NOISE_SIZE;
+
+		for (int y = 0; y < BLUE_NOISE_SIZE; ++y) {
+			for (int x = 0; x < BLUE_NOISE_SIZE; ++x) {
+				int offset_x = (x - point_x + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE;
+				int offset_y = (y - point_y + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE;
+				energy[y * BLUE_NOISE_SIZE + x] += kernel[offset_y * BLUE_NOISE_SIZE + offset_x];
+			}
+		}
+	}
+}
+
+glm::vec2 BlueNoiseSampler::sample(unsigned x, unsigned y, unsigned index, unsigned dimension, unsigned frame) const {
+	//reads the shifts of other dimensions from distant parts of the mask, so they do not correlate
+	unsigned offset = hash_bits(frame_seed(dimension, frame));
+	unsigned mask_x = (x + offset) % BLUE_NOISE_SIZE;
+	unsigned mask_y = (y + (offset >> 8)) % BLUE_NOISE_SIZE;
+	float shift_x = mask_[mask_y * BLUE_NOISE_SIZE + mask_x];
+	float shift_y = mask_[((mask_y + BLUE_NOISE_SIZE / 2) % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + (mask_x + BLUE_NOISE_SIZE / 2) % BLUE_NOISE_SIZE];
+
+	if (dimension > 0) {
+		index = shuffle_index(index, hash_bits(offset, x, y));
+	}
+	return {
+			wrap_unit(to_unit_float(reverse_bits(index)) + shift_x),
+			wrap_unit(to_unit_float(sobol_second_dimension(index)) + shift_y)};
+}
+
+std::shared_ptr<Sampler const> make_sampler(SamplerType type, unsigned grid_size) {
+	switch (type) {
+		case SamplerType::stratified:
+			return std::make_shared<StratifiedSampler>(grid_size);
+		case SamplerType::halton:
+			return std::make_shared<HaltonSampler>();
+		case SamplerType::sobol:
+			return std::make_shared<SobolSampler>();
+		case SamplerType::blue_noise:
+			return std::make_shared<BlueNoiseSampler>();
+		default:
+			return std::make_shared<GridSampler>(grid_size);
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef RAYTRACER_SAMPLER_HPP
+#define RAYTRACER_SAMPLER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+//point sets that samplers spread the samples of a pixel with
+enum class SamplerType {
+	//regular grid, the same positions in every pixel
+	grid,
+	//one randomly placed sample in each cell of a grid
+	stratified,
+	//Halton sequence, shifted randomly in each pixel
+	halton,
+	//Sobol (0,2) sequence, scrambled randomly in each pixel
+	sobol,
+	//Sobol sequence, shifted in each pixel by a blue noise mask so the error of neighboring pixels differs as much as possible
+	blue_noise
+};
+
+/**
+ * Generates well distributed 2D samples for the pixels of an image.
+ * Samples only depend on their arguments, so threads can share one sampler and every render is reproducible,
+ * no matter which thread renders which pixel.
+ */
+class Sampler {
+public:
+	virtual ~Sampler() = default;
+	/**
+	 * @param x column of the pixel
+	 * @param y row of the pixel
+	 * @param index number of the sample in the pixel
+	 * @param dimension what the sample is used for, 0 for the position in the pixel, the following ones for lights and bounces
+	 * @param frame number of the image in an animation, scrambles the samples differently in every frame
+	 * @return point in [0, 1)²
+	 */
+	virtual glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const = 0;
+};
+
+class GridSampler : public Sampler {
+public:
+	//@param grid_size samples along each side of the pixel, further samples repeat the grid
+	explicit GridSampler(unsigned grid_size);
+	glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const override;
+
+private:
+	unsigned grid_size_;
+};
+
+class StratifiedSampler : public Sampler {
+public:
+	//@param grid_size cells along each side of the pixel, further samples are placed in the cells again
+	explicit StratifiedSampler(unsigned grid_size);
+	glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const override;
+
+private:
+	unsigned grid_size_;
+};
+
+class HaltonSampler : public Sampler {
+public:
+	glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const override;
+};
+
+class SobolSampler : public Sampler {
+public:
+	glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const override;
+};
+
+class BlueNoiseSampler : public Sampler {
+public:
+	BlueNoiseSampler();
+	glm::vec2 sample(unsigned x, unsigned y, unsigned index, unsigned dimension = 0, unsigned frame = 0) const override;
+
+private:
+	//values in [0, 1) without low frequencies, repeated over the image
+	std::vector<float> mask_;
+};
+
+/**
+ * @param grid_size samples along each side of a pixel for the grid based samplers
+ */
+std::shared_ptr<Sampler const> make_sampler(SamplerType type, unsigned grid_size);
+
+//scrambles the bits of a number, so numbers that differ a little get unrelated hashes
+uint32_t hash_bits(uint32_t x);
+uint32_t hash_bits(uint32_t a, uint32_t b, uint32_t c);
+//maps the highest 24 bits to [0, 1), more do not fit into a float
+float to_unit_float(uint32_t bits);
+float radical_inverse(unsigned index, unsigned base);
+
+#endif
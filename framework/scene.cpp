@@ -2,9 +2,15 @@
 #include <sstream>
 #include <algorithm>
 #include <string>
+#include <iostream>
 
 #include "scene.hpp"
 #include "sphere.hpp"
+#include "simplify.hpp"
+#include "threadPool.hpp"
+
+//objects are not simplified below this amount of triangles
+#define LOD_MIN_FACES 64
 
 std::shared_ptr<Material> Scene::find_mat(std::string const& name) const {
 	return materials.find(name)->second;
@@ -89,7 +95,12 @@ PointLight load_point_light(std::istringstream& arg_stream) {
 	glm::vec3 pos = load_vec(arg_stream);
 	Color color = load_color(arg_stream);
 	arg_stream >> brightness;
-	return {name, color, pos, brightness};
+	PointLight light {name, color, pos, brightness};
+
+	if (!(arg_stream >> light.radius)) {
+		light.radius = 0;
+	}
+	return light;
 }
 
 Light load_ambient(std::istringstream& arg_stream) {
@@ -121,6 +132,10 @@ Camera load_camera(std::istringstream& arg_stream) {
 	arg_stream >> pitch;
 	arg_stream >> roll;
 
+	return make_camera(name, fov_x, position, yaw, pitch, roll);
+}
+
+Camera make_camera(std::string const& name, float fov_x, glm::vec3 const& position, float yaw, float pitch, float roll) {
 	glm::mat4 cam_rotation = glm::eulerAngleYXZ(glm::radians(yaw), glm::radians(pitch), glm::radians(roll));
 	return {name, fov_x, position, transform_vec({0, 0, -1}, cam_rotation, false), transform_vec({0, 1, 0}, cam_rotation, false)};
 }
@@ -174,51 +189,147 @@ std::map<std::string, std::shared_ptr<Material>> load_obj_materials(std::string
 	return materials;
 }
 
-std::shared_ptr<Triangle> load_obj_face(
+/**
+ * Reads a face with any amount of corners. Flat convex faces with four corners are kept as quads,
+ * all other faces are split into a fan of triangles around the first corner
+ * @param triangles list to add triangle faces to
+ * @param quads list to add quad faces to
+ */
+void load_obj_face(
 		std::istringstream& arg_stream,
 		std::vector<glm::vec3> const& vertices,
 		std::vector<glm::vec3> const& normals,
-		std::string const& name,
-		std::shared_ptr<Material> mat) {
-	unsigned indices_v[3];
-	unsigned indices_vt[3];
-	unsigned indices_vn[3];
-	bool has_normals = false;
-
-	for (int i = 0; i < 3; ++i) {
-		std::string index_group;
-		arg_stream >> index_group;
+		std::shared_ptr<Material> mat,
+		std::vector<MeshTriangle>& triangles,
+		std::vector<MeshQuad>& quads) {
+	std::vector<glm::vec3> corners;
+	unsigned index_vn = 0;
+	std::string index_group;
+
+	while (arg_stream >> index_group) {
 		std::stringstream index_stream(index_group);
+		unsigned index_v;
+		unsigned index_vt;
 
-		index_stream >> indices_v[i];
+		index_stream >> index_v;
+		corners.push_back(vertices[index_v - 1]);
 		index_stream.ignore();
 		//skips texture coordinates if non provided for a face
 		if ('/' != index_stream.peek()) {
-			index_stream >> indices_vt[i];
+			index_stream >> index_vt;
 		}
-		//reads face normals if provided
-		if (-1 != index_stream.peek()) {
+		//reads the face normal from the first corner if provided
+		if (-1 != index_stream.peek() && 0 == index_vn) {
 			index_stream.ignore();
-			index_stream >> indices_vn[i];
-			has_normals = true;
+			index_stream >> index_vn;
 		}
 	}
-	if (has_normals) {
-		return std::make_shared<Triangle>(
-				vertices[indices_v[0] - 1],
-				vertices[indices_v[1] - 1],
-				vertices[indices_v[2] - 1],
-				normals[indices_vn[0] - 1],
-				name,
-				mat);
-	}else {
-		return std::make_shared<Triangle>(
-				vertices[indices_v[0] - 1],
-				vertices[indices_v[1] - 1],
-				vertices[indices_v[2] - 1],
-				name,
-				mat);
+	if (corners.size() < 3) {
+		return;
+	}
+	if (4 == corners.size() && is_flat_convex_quad(corners[0], corners[1], corners[2], corners[3])) {
+		MeshQuad quad {corners[0], corners[1], corners[2], corners[3]};
+		quad.n = 0 != index_vn ? normals[index_vn - 1] : glm::normalize(glm::cross(quad.v2 - quad.v0, quad.v3 - quad.v1));
+		quad.material = mat;
+		quads.push_back(quad);
+		return;
+	}
+	for (unsigned i = 2; i < corners.size(); ++i) {
+		MeshTriangle face {corners[0], corners[i - 1], corners[i]};
+		face.n = 0 != index_vn ? normals[index_vn - 1] : glm::normalize(glm::cross(face.v1 - face.v0, face.v2 - face.v0));
+		face.material = mat;
+		triangles.push_back(face);
+	}
+}
+
+//splits quads into two triangles for the mesh formats that only store triangles
+std::vector<MeshTriangle> split_quads(std::vector<MeshTriangle> const& faces, std::vector<MeshQuad> const& quads) {
+	std::vector<MeshTriangle> triangles = faces;
+	triangles.reserve(faces.size() + 2 * quads.size());
+
+	for (MeshQuad const& quad : quads) {
+		triangles.push_back({quad.v0, quad.v1, quad.v2, quad.n, quad.material});
+		triangles.push_back({quad.v0, quad.v2, quad.v3, quad.n, quad.material});
+	}
+	return triangles;
+}
+
+/**
+ * Creates the shape for one object of an .obj file in the requested mesh format
+ * @param faces triangles of the object
+ * @param quads quads of the object
+ * @param name name of the object
+ * @param face_count amount of faces of previous objects used to name the faces
+ * @param format storage format of the mesh
+ */
+std::shared_ptr<Shape> build_obj_mesh(
+		std::vector<MeshTriangle> const& faces,
+		std::vector<MeshQuad> const& quads,
+		std::string const& name,
+		unsigned face_count,
+		MeshFormat format) {
+	if (MeshFormat::compressed == format) {
+		return std::make_shared<CompressedMesh>(split_quads(faces, quads), name);
+	}
+	auto object = std::make_shared<Composite>(name, nullptr);
+
+	for (MeshTriangle const& face : faces) {
+		object->add_child(std::make_shared<Triangle>(face.v0, face.v1, face.v2, face.n, "face" + std::to_string(face_count), face.material));
+		++face_count;
+	}
+	for (MeshQuad const& quad : quads) {
+		object->add_child(std::make_shared<Quad>(quad.v0, quad.v1, quad.v2, quad.v3, quad.n, "face" + std::to_string(face_count), quad.material));
+		++face_count;
+	}
+	object->flatten();
+	return object;
+}
+
+/**
+ * Creates the shape for one object of an .obj file, together with simplified versions of it if requested
+ * @param faces triangles of the object
+ * @param quads quads of the object
+ * @param name name of the object
+ * @param face_count amount of faces of previous objects used to name the triangles
+ * @param options storage format and amount of detail levels
+ */
+std::shared_ptr<Shape> build_obj_object(
+		std::vector<MeshTriangle> const& faces,
+		std::vector<MeshQuad> const& quads,
+		std::string const& name,
+		unsigned face_count,
+		MeshOptions const& options) {
+	std::shared_ptr<Shape> mesh = build_obj_mesh(faces, quads, name, face_count, options.format);
+
+	if (0 == options.lod_levels) {
+		return mesh;
+	}
+	std::vector<std::shared_ptr<Shape>> levels {mesh};
+	std::vector<MeshTriangle> level_faces = split_quads(faces, quads);
+	std::vector<float> edge_lengths {mean_edge_length(level_faces)};
+
+	//simplifies each level from the previous one and stops once the objects are too coarse to be reduced further
+	for (unsigned level = 1; level <= options.lod_levels && level_faces.size() >= 4 * LOD_MIN_FACES; ++level) {
+		level_faces = simplify_mesh(level_faces, level_faces.size() / 4);
+		levels.push_back(build_obj_mesh(level_faces, {}, name + "_lod" + std::to_string(level), face_count, options.format));
+		edge_lengths.push_back(mean_edge_length(level_faces));
+	}
+	if (1 == levels.size()) {
+		return mesh;
 	}
+	return std::make_shared<LodMesh>(levels, edge_lengths, name);
+}
+
+//builds an object of an .obj file on the thread pool and takes over its faces
+std::future<std::shared_ptr<Shape>> submit_obj_object(
+		std::vector<MeshTriangle> faces,
+		std::vector<MeshQuad> quads,
+		std::string const& name,
+		unsigned face_count,
+		MeshOptions const& options) {
+	return ThreadPool::global().submit([faces = std::move(faces), quads = std::move(quads), name, face_count, options]() {
+		return build_obj_object(faces, quads, name, face_count, options);
+	});
 }
 
 /**
@@ -227,18 +338,34 @@ std::shared_ptr<Triangle> load_obj_face(
  * @param name name of the .obj file
  * @return
  */
-std::shared_ptr<Composite> load_obj(std::string const& directory_path, std::string const& name) {
+std::shared_ptr<Composite> load_obj(std::string const& directory_path, std::string const& name, MeshOptions const& options) {
 	std::ifstream input_obj_file(directory_path + name + ".obj");
+	return load_obj(input_obj_file, directory_path, name, options);
+}
+
+/**
+ * Loads a blender generated .obj file from an already opened stream
+ * @param input_obj_file stream of the .obj file contents
+ * @param directory_path directory to look for referenced .mtl files in
+ * @param name name of the .obj file
+ * @param options storage format and detail levels for the meshes of the file
+ * @return
+ */
+std::shared_ptr<Composite> load_obj(std::istream& input_obj_file, std::string const& directory_path, std::string const& name, MeshOptions const& options) {
 	std::string line_buffer;
 
 	std::map<std::string, std::shared_ptr<Material>> materials;
 	auto composite = std::make_shared<Composite>(name, nullptr);
-	std::shared_ptr<Composite> current_child = composite;
+	std::string child_name = name;
 	std::shared_ptr<Material> child_mat = std::make_shared<Material>();
 	std::vector<glm::vec3> vertices;
 	std::vector<glm::vec3> normals;
+	std::vector<MeshTriangle> faces;
+	std::vector<MeshQuad> quads;
+	//objects that are built on the thread pool while the file is read further
+	std::vector<std::future<std::shared_ptr<Shape>>> objects;
 
-	int face_count = 0;
+	unsigned face_count = 0;
 
 	while (std::getline(input_obj_file, line_buffer)) {
 		std::istringstream arg_stream(line_buffer);
@@ -255,14 +382,15 @@ std::shared_ptr<Composite> load_obj(std::string const& directory_path, std::stri
 			materials = load_obj_materials(directory_path + mtl_file_name);
 			//creates new sub object
 		} else if ("o" == token) {
-			//adds the previously composed mesh after all faces have been added so it's min max bounds are calculated correctly
-			if (composite->get_name() != current_child->get_name()) {
-				current_child->build_octree();
-				composite->add_child(current_child);
+			//builds the previously composed mesh after all faces have been added so it's min max bounds are calculated correctly
+			if (!faces.empty() || !quads.empty()) {
+				unsigned object_face_count = faces.size() + quads.size();
+				objects.push_back(submit_obj_object(std::move(faces), std::move(quads), child_name, face_count, options));
+				face_count += object_face_count;
+				faces.clear();
+				quads.clear();
 			}
-			std::string child_name;
 			arg_stream >> child_name;
-			current_child = std::make_shared<Composite>(child_name, child_mat);
 			//adds vertex
 		} else if ("v" == token) {
 			vertices.push_back(load_vec(arg_stream));
@@ -274,34 +402,111 @@ std::shared_ptr<Composite> load_obj(std::string const& directory_path, std::stri
 			std::string mat_name;
 			arg_stream >> mat_name;
 			child_mat = materials.find(mat_name)->second;
-			//adds a triangle face
+			//adds a face
 		} else if ("f" == token) {
-			current_child->add_child(load_obj_face(arg_stream, vertices, normals, "face" + std::to_string(face_count), child_mat));
-			++face_count;
+			load_obj_face(arg_stream, vertices, normals, child_mat, faces, quads);
 		}
 	}
-	if (composite->get_name() != current_child->get_name()) {
-		current_child->build_octree();
-		composite->add_child(current_child);
+	if (!faces.empty() || !quads.empty()) {
+		objects.push_back(submit_obj_object(std::move(faces), std::move(quads), child_name, face_count, options));
 	}
-//	composite->translate(0, -5, -12);
-//	composite->rotate(1.5, 0, 0);
-	composite->build_octree();
+	for (auto& object : objects) {
+		composite->add_child(ThreadPool::global().wait(object));
+	}
+	composite->flatten();
 	return composite;
-};
+}
+
+/**
+ * Returns the mesh of an .obj file and only parses the file if no file with the same path and content was loaded before
+ * @param directory_path directory of the .obj file
+ * @param name name of the .obj file
+ * @param assets cache of previously loaded meshes
+ * @param options storage format and detail levels for the meshes of the file
+ * @return mesh shared by all callers loading the same file
+ */
+std::shared_ptr<Composite const> load_obj_asset(
+		std::string const& directory_path,
+		std::string const& name,
+		std::map<std::string, std::shared_ptr<Composite const>>& assets,
+		MeshOptions const& options) {
+	std::string file_path = directory_path + name + ".obj";
+	std::ifstream input_obj_file(file_path);
+	std::stringstream content;
+	content << input_obj_file.rdbuf();
+
+	std::string key = file_path + "#" + std::to_string(std::hash<std::string>{}(content.str())) +
+			"#" + std::to_string((int) options.format) + "#" + std::to_string(options.lod_levels);
+	auto it = assets.find(key);
+
+	if (assets.end() != it) {
+		return it->second;
+	}
+	std::shared_ptr<Composite const> mesh = load_obj(content, directory_path, name, options);
+	assets.emplace(key, mesh);
+	return mesh;
+}
 
-void render(std::istringstream& arg_stream) {
-	std::string cam_name;
+/**
+ * Reads an .obj file name followed by an optional instance name and material that overrides the materials of the file
+ */
+std::shared_ptr<Instance> load_obj_instance(std::istringstream& arg_stream, Scene& scene) {
 	std::string file_name;
-	unsigned int res_x;
-	unsigned int res_y;
+	std::string name;
+	std::string mat_name;
 
-	arg_stream >> cam_name;
 	arg_stream >> file_name;
-	arg_stream >> res_x;
-	arg_stream >> res_y;
+	//names the instance after the file if no other name is given
+	if (!(arg_stream >> name)) {
+		name = file_name;
+	}
+	std::shared_ptr<Material> mat = nullptr;
+
+	if (arg_stream >> mat_name) {
+		auto it = scene.materials.find(mat_name);
 
-	//NOT IMPLEMENTED FOR THIS ASSIGNMENT
+		if (scene.materials.end() != it) {
+			mat = it->second;
+		}
+	}
+	return std::make_shared<Instance>(load_obj_asset("../../sdf/", file_name, scene.assets, scene.mesh_options), name, mat);
+}
+
+RenderCommand load_render_command(std::istringstream& arg_stream) {
+	RenderCommand command;
+	arg_stream >> command.camera_name;
+	arg_stream >> command.file_name;
+	arg_stream >> command.width;
+	arg_stream >> command.height;
+
+	//the frame range is optional, a single image is frame 0
+	if (arg_stream >> command.first_frame) {
+		arg_stream >> command.last_frame;
+		command.last_frame = std::max(command.first_frame, command.last_frame);
+	}
+	return command;
+}
+
+//key <frame> transform <shape> translate|rotate|scale x y z
+//key <frame> camera <name> fov_x x y z yaw pitch roll
+AnimationKey load_key(std::istringstream& arg_stream) {
+	AnimationKey key;
+	std::string type;
+	arg_stream >> key.frame;
+	arg_stream >> type;
+	arg_stream >> key.target;
+
+	if ("camera" == type) {
+		key.action = "camera";
+	} else {
+		arg_stream >> key.action;
+	}
+	float value;
+
+	while (arg_stream >> value) {
+		key.values.push_back(value);
+	}
+	return key;
 }
 
 void add_to_scene(std::istringstream& arg_stream, Scene& scene) {
@@ -321,10 +526,13 @@ void add_to_scene(std::istringstream& arg_stream, Scene& scene) {
 		} else if ("triangle" == token) {
 			scene.root->add_child(load_triangle(arg_stream, scene.materials));
 		} else if ("obj" == token) {
-			std::string obj_file_name;
-			arg_stream >> obj_file_name;
-			scene.root->add_child(load_obj("../../sdf/", obj_file_name));
+			scene.root->add_child(load_obj_instance(arg_stream, scene));
 		}
+	} else if ("mesh_format" == token) {
+		arg_stream >> token;
+		scene.mesh_options.format = "compressed" == token ? MeshFormat::compressed : MeshFormat::triangles;
+	} else if ("lod_levels" == token) {
+		arg_stream >> scene.mesh_options.lod_levels;
 	} else if ("light" == token) {
 		scene.lights.push_back(load_point_light(arg_stream));
 	} else if ("ambient" == token) {
@@ -343,6 +551,9 @@ void transform(std::istringstream& arg_stream, Scene& scene) {
 
 	auto shape = scene.root->find_child(name);
 
+	if (nullptr == shape) {
+		return;
+	}
 	if ("translate" == action) {
 		float x;
 		float y;
@@ -390,11 +601,25 @@ Scene load_scene(std::string const& file_path) {
 		if ("define" == token_str) {
 			add_to_scene(arg_stream, scene);
 		} else if ("render" == token_str) {
-			render(arg_stream);
+			scene.render_commands.push_back(load_render_command(arg_stream));
+		} else if ("key" == token_str) {
+			scene.keys.push_back(load_key(arg_stream));
 		} else if ("transform" == token_str) {
 			transform(arg_stream, scene);
 		}
 	}
-	scene.root->build_octree();
+	std::stable_sort(scene.keys.begin(), scene.keys.end(), [](AnimationKey const& a, AnimationKey const& b) {
+		return a.frame < b.frame;
+	});
+	//keys can only move the camera and the shapes the root holds directly, the others would be ignored when rendering
+	for (AnimationKey const& key : scene.keys) {
+		bool is_camera = "camera" == key.action;
+
+		if (is_camera ? key.target != scene.camera.name : nullptr == scene.root->find_child(key.target)) {
+			std::cerr << "key of frame " << key.frame << " names unknown " << (is_camera ? "camera " : "shape ") << key.target
+			          << std::endl;
+		}
+	}
+	scene.root->flatten();
 	return scene;
 }
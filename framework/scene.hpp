@@ -7,15 +7,62 @@
 #include "light.hpp"
 #include "composite.hpp"
 #include "triangle.hpp"
+#include "quad.hpp"
+#include "instance.hpp"
+#include "compressedMesh.hpp"
+#include "lodMesh.hpp"
 #include <vector>
 #include <map>
 
+//storage format of meshes loaded from .obj files
+enum class MeshFormat {
+	//one Triangle or Quad shape per face
+	triangles,
+	//quantized positions and normals with 24 bytes per face
+	compressed
+};
+
+struct MeshOptions {
+	MeshFormat format = MeshFormat::triangles;
+	//amount of simplified versions generated for each object, each with a quarter of the triangles of the previous one
+	unsigned lod_levels = 0;
+};
+
+//value of a shape transformation or camera at one frame of an animation, frames between two keys are interpolated
+struct AnimationKey {
+	unsigned frame = 0;
+	//name of the animated shape or camera
+	std::string target;
+	//translate, rotate or scale for shapes, camera for cameras
+	std::string action;
+	//x, y and z of a transformation, angles in degrees, or field of view, position, yaw, pitch and roll of a camera
+	std::vector<float> values;
+};
+
+//image or range of animation frames to render, each frame is saved to its own file
+struct RenderCommand {
+	std::string camera_name;
+	//a run of # in the name is replaced with the frame number, padded with zeros
+	std::string file_name;
+	unsigned width = 0;
+	unsigned height = 0;
+	unsigned first_frame = 0;
+	unsigned last_frame = 0;
+};
+
 struct Scene {
 	std::shared_ptr<Composite> root = std::make_shared<Composite>("root");
 	std::map<std::string, std::shared_ptr<Material>> materials{};
+	//meshes of loaded .obj files by path and content hash, shared by all instances of the same file
+	std::map<std::string, std::shared_ptr<Composite const>> assets{};
+	MeshOptions mesh_options{};
 	std::vector<PointLight> lights{};
 	Light ambient{};
 	Camera camera{};
+	std::vector<AnimationKey> keys{};
+	std::vector<RenderCommand> render_commands{};
+	//transformations of the animated shapes before their keys were applied, which the keys are relative to
+	std::map<std::string, glm::mat4> rest_transforms{};
 
 	std::shared_ptr<Material> find_mat(std::string const& name) const;
 };
@@ -23,15 +70,30 @@ struct Scene {
 
 std::shared_ptr<Material> load_mat(std::istringstream& arg_stream);
 void add_to_scene(std::istringstream& arg_stream, Scene& scene);
+Camera make_camera(std::string const& name, float fov_x, glm::vec3 const& position, float yaw, float pitch, float roll);
 Scene load_scene(std::string const& file_path);
 
 std::map<std::string, std::shared_ptr<Material>> load_obj_materials(std::string const& file_path);
-std::shared_ptr<Triangle> load_obj_face(
+void load_obj_face(
 		std::istringstream& arg_stream,
 		std::vector<glm::vec3> const& vertices,
 		std::vector<glm::vec3> const& normals,
+		std::shared_ptr<Material> mat,
+		std::vector<MeshTriangle>& triangles,
+		std::vector<MeshQuad>& quads);
+std::shared_ptr<Composite> load_obj(
+		std::string const& directory_path,
+		std::string const& name,
+		MeshOptions const& options = {});
+std::shared_ptr<Composite> load_obj(
+		std::istream& input_obj_file,
+		std::string const& directory_path,
+		std::string const& name,
+		MeshOptions const& options = {});
+std::shared_ptr<Composite const> load_obj_asset(
+		std::string const& directory_path,
 		std::string const& name,
-		std::shared_ptr<Material> mat);
-std::shared_ptr<Composite> load_obj(std::string const& directory_path, std::string const& name);
+		std::map<std::string, std::shared_ptr<Composite const>>& assets,
+		MeshOptions const& options = {});
 
 #endif
\ No newline at end of file
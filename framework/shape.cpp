@@ -10,8 +10,13 @@ std::string Shape::get_name() const {
 	return name_;
 }
 
+glm::mat4 const& Shape::world_transform() const {
+	return world_transform_;
+}
+
 void Shape::transform(glm::mat4 const& transformation) {
 	world_transform_ = transformation;
+	world_transform_inv_ = glm::inverse(world_transform_);
 }
 
 void Shape::scale(float sx, float sy, float sz) {
@@ -35,6 +40,19 @@ void Shape::translate(float x, float y, float z) {
 	world_transform_inv_ = glm::inverse(world_transform_);
 }
 
+void Shape::intersect_packet(RayPacket const& packet, HitPoint* hits) const {
+	for (unsigned i = 0; i < packet.size; ++i) {
+		if (!packet.is_active(i)) {
+			continue;
+		}
+		HitPoint hit = intersect(packet.rays[i]);
+
+		if (is_closer(hit, hits[i])) {
+			hits[i] = hit;
+		}
+	}
+}
+
 std::ostream& Shape::print(std::ostream &os) const {
 	return os << "=== " << name_ << " ===" << "\ncolor:"<< material_;
 }
@@ -48,5 +66,19 @@ glm::vec3 transform_vec(glm::vec3 const& vec, glm::mat4 const& transformation, b
 }
 
 Ray transform_ray(Ray const& ray, glm::mat4 const& transformation) {
-	return Ray{transform_vec(ray.origin, transformation), transform_vec(ray.direction, transformation, false)};
+	return Ray{transform_vec(ray.origin, transformation), transform_vec(ray.direction, transformation, false), ray.cone_width, ray.cone_spread};
+}
+
+RayPacket transform_packet(RayPacket const& packet, glm::mat4 const& transformation) {
+	RayPacket transformed {};
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		transformed.add(transform_ray(packet.rays[i], transformation));
+	}
+	transformed.active_mask = packet.active_mask;
+	return transformed;
+}
+
+bool is_closer(HitPoint const& hit, HitPoint const& closest_hit) {
+	return hit.does_intersect && (!closest_hit.does_intersect || hit.distance < closest_hit.distance);
 }
@@ -12,6 +12,7 @@
 #include "color.hpp"
 #include "hitPoint.hpp"
 #include "ray.hpp"
+#include "rayPacket.hpp"
 #include "material.hpp"
 #include "printVec3.hpp"
 
@@ -21,11 +22,17 @@ public:
 	Shape(std::string const& name, std::shared_ptr<Material> material);
 
 	virtual std::string get_name() const;
+	glm::mat4 const& world_transform() const;
 	virtual float area() const = 0;
 	virtual float volume() const = 0;
 	virtual glm::vec3 min(glm::mat4 const& transform = glm::mat4()) const = 0;
 	virtual glm::vec3 max(glm::mat4 const& transform = glm::mat4()) const = 0;
 	virtual HitPoint intersect(Ray const& ray) const = 0;
+	/**
+	 * Intersects all rays of a packet and replaces hits[i] wherever ray i hits this shape closer than before.
+	 * Shapes without an own packet test intersect the rays one by one.
+	 */
+	virtual void intersect_packet(RayPacket const& packet, HitPoint* hits) const;
 
 	virtual void transform(glm::mat4 const& transformation);
 	virtual void scale(float sx, float sy, float sz);
@@ -43,5 +50,8 @@ protected:
 std::ostream& operator<<(std::ostream& os, Shape const& s);
 glm::vec3 transform_vec(glm::vec3 const& vec, glm::mat4 const& transformation, bool is_location = true);
 Ray transform_ray(Ray const& ray, glm::mat4 const& transformation);
+RayPacket transform_packet(RayPacket const& packet, glm::mat4 const& transformation);
+//true if the hit is closer than the closest hit found so far
+bool is_closer(HitPoint const& hit, HitPoint const& closest_hit);
 
 #endif
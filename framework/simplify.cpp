@@ -0,0 +1,268 @@
+#include <map>
+#include <tuple>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include "simplify.hpp"
+
+//minimum cosine between a face normal before and after a collapse, prevents faces from flipping over
+#define MIN_NORMAL_COSINE 0.2
+//weight of the planes that keep open mesh borders in place
+#define BORDER_WEIGHT 1000.0
+
+struct EdgeCollapse {
+	double cost;
+	unsigned u;
+	unsigned v;
+	unsigned version_u;
+	unsigned version_v;
+	glm::dvec3 target;
+
+	bool operator>(EdgeCollapse const& other) const {
+		return cost > other.cost;
+	}
+};
+
+glm::dmat4 plane_quadric(glm::dvec3 const& normal, glm::dvec3 const& point) {
+	glm::dvec4 plane {normal, -glm::dot(normal, point)};
+	glm::dmat4 quadric;
+
+	for (int col = 0; col < 4; ++col) {
+		quadric[col] = plane * plane[col];
+	}
+	return quadric;
+}
+
+double quadric_error(glm::dmat4 const& quadric, glm::dvec3 const& v) {
+	glm::dvec4 v4 {v, 1};
+	return glm::dot(v4, quadric * v4);
+}
+
+/**
+ * Finds the position with the lowest error for the merged vertex of an edge.
+ * Falls back to the end points or the middle of the edge if the quadric cannot be inverted.
+ */
+EdgeCollapse find_collapse(glm::dmat4 const& quadric, unsigned u, unsigned v, glm::dvec3 const& pos_u, glm::dvec3 const& pos_v) {
+	glm::dmat3 a {glm::dvec3 {quadric[0]}, glm::dvec3 {quadric[1]}, glm::dvec3 {quadric[2]}};
+	EdgeCollapse collapse {0, u, v, 0, 0, (pos_u + pos_v) * 0.5};
+
+	if (std::abs(glm::determinant(a)) > 1e-12) {
+		collapse.target = glm::inverse(a) * -glm::dvec3 {quadric[3]};
+		//rejects optimal positions that lie far away from the edge in badly conditioned cases
+		double edge_length = glm::length(pos_v - pos_u);
+
+		if (!std::isfinite(collapse.target.x + collapse.target.y + collapse.target.z) ||
+		    glm::length(collapse.target - (pos_u + pos_v) * 0.5) > 2 * edge_length) {
+			collapse.target = (pos_u + pos_v) * 0.5;
+		}
+	}
+	collapse.cost = quadric_error(quadric, collapse.target);
+
+	for (glm::dvec3 const& candidate : {pos_u, pos_v}) {
+		double cost = quadric_error(quadric, candidate);
+
+		if (cost < collapse.cost) {
+			collapse.cost = cost;
+			collapse.target = candidate;
+		}
+	}
+	return collapse;
+}
+
+//https://www.cs.cmu.edu/~./garland/Papers/quadrics.pdf
+std::vector<MeshTriangle> simplify_mesh(std::vector<MeshTriangle> const& faces, unsigned target_count) {
+	//welds vertices with equal positions so the faces share them
+	std::map<std::tuple<float, float, float>, unsigned> vertex_indices;
+	std::vector<glm::dvec3> positions;
+	std::vector<glm::uvec3> triangles;
+	triangles.reserve(faces.size());
+
+	for (MeshTriangle const& face : faces) {
+		glm::uvec3 triangle;
+
+		for (int i = 0; i < 3; ++i) {
+			glm::vec3 const& v = 0 == i ? face.v0 : 1 == i ? face.v1 : face.v2;
+			auto it = vertex_indices.emplace(std::make_tuple(v.x, v.y, v.z), positions.size());
+
+			if (it.second) {
+				positions.emplace_back(v);
+			}
+			triangle[i] = it.first->second;
+		}
+		triangles.push_back(triangle);
+	}
+	std::vector<glm::dmat4> quadrics(positions.size(), glm::dmat4(0));
+	std::vector<std::vector<unsigned>> vertex_faces(positions.size());
+	std::vector<bool> is_face_removed(triangles.size(), false);
+	std::map<std::pair<unsigned, unsigned>, int> edge_uses;
+	unsigned face_count = 0;
+
+	for (unsigned f = 0; f < triangles.size(); ++f) {
+		glm::uvec3 const& t = triangles[f];
+		glm::dvec3 normal = glm::cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]);
+		double area = glm::length(normal);
+
+		//drops faces that have already collapsed in the source mesh
+		if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0] || 0 == area) {
+			is_face_removed[f] = true;
+			continue;
+		}
+		++face_count;
+		normal /= area;
+		glm::dmat4 quadric = plane_quadric(normal, positions[t[0]]);
+
+		for (int i = 0; i < 3; ++i) {
+			quadrics[t[i]] += quadric;
+			vertex_faces[t[i]].push_back(f);
+			++edge_uses[std::minmax(t[i], t[(i + 1) % 3])];
+		}
+	}
+	//keeps the silhouette of open meshes by adding planes perpendicular to the border faces
+	for (unsigned f = 0; f < triangles.size(); ++f) {
+		if (is_face_removed[f]) {
+			continue;
+		}
+		glm::uvec3 const& t = triangles[f];
+		glm::dvec3 normal = glm::normalize(glm::cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]));
+
+		for (int i = 0; i < 3; ++i) {
+			unsigned a = t[i];
+			unsigned b = t[(i + 1) % 3];
+
+			if (1 != edge_uses[std::minmax(a, b)]) {
+				continue;
+			}
+			glm::dvec3 border_normal = glm::cross(positions[b] - positions[a], normal);
+
+			if (0 == glm::length(border_normal)) {
+				continue;
+			}
+			glm::dmat4 quadric = plane_quadric(glm::normalize(border_normal), positions[a]) * BORDER_WEIGHT;
+			quadrics[a] += quadric;
+			quadrics[b] += quadric;
+		}
+	}
+	std::vector<unsigned> versions(positions.size(), 0);
+	std::vector<bool> is_vertex_removed(positions.size(), false);
+	std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>, std::greater<EdgeCollapse>> collapses;
+
+	auto push_collapse = [&](unsigned u, unsigned v) {
+		EdgeCollapse collapse = find_collapse(quadrics[u] + quadrics[v], u, v, positions[u], positions[v]);
+		collapse.version_u = versions[u];
+		collapse.version_v = versions[v];
+		collapses.push(collapse);
+	};
+	for (auto const& it : edge_uses) {
+		push_collapse(it.first.first, it.first.second);
+	}
+	//checks that no face around a vertex flips over when the vertex moves to the new position
+	auto flips_faces = [&](unsigned moved, unsigned other, glm::dvec3 const& target) {
+		for (unsigned f : vertex_faces[moved]) {
+			glm::uvec3 const& t = triangles[f];
+
+			if (is_face_removed[f] || t[0] == other || t[1] == other || t[2] == other) {
+				continue;
+			}
+			glm::dvec3 p[3] {positions[t[0]], positions[t[1]], positions[t[2]]};
+			glm::dvec3 old_normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+			for (int i = 0; i < 3; ++i) {
+				if (t[i] == moved) {
+					p[i] = target;
+				}
+			}
+			glm::dvec3 new_normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+			double lengths = glm::length(old_normal) * glm::length(new_normal);
+
+			if (0 == lengths || glm::dot(old_normal, new_normal) < MIN_NORMAL_COSINE * lengths) {
+				return true;
+			}
+		}
+		return false;
+	};
+	while (face_count > target_count && !collapses.empty()) {
+		EdgeCollapse collapse = collapses.top();
+		collapses.pop();
+		unsigned u = collapse.u;
+		unsigned v = collapse.v;
+
+		//skips collapses that were calculated before one of the vertices changed
+		if (is_vertex_removed[u] || is_vertex_removed[v] || versions[u] != collapse.version_u || versions[v] != collapse.version_v) {
+			continue;
+		}
+		if (flips_faces(u, v, collapse.target) || flips_faces(v, u, collapse.target)) {
+			continue;
+		}
+		//merges v into u
+		positions[u] = collapse.target;
+		quadrics[u] += quadrics[v];
+		is_vertex_removed[v] = true;
+		++versions[u];
+
+		for (unsigned f : vertex_faces[v]) {
+			if (is_face_removed[f]) {
+				continue;
+			}
+			glm::uvec3& t = triangles[f];
+
+			if (t[0] == u || t[1] == u || t[2] == u) {
+				is_face_removed[f] = true;
+				--face_count;
+				continue;
+			}
+			for (int i = 0; i < 3; ++i) {
+				if (t[i] == v) {
+					t[i] = u;
+				}
+			}
+			vertex_faces[u].push_back(f);
+		}
+		vertex_faces[v].clear();
+		//drops removed faces from the adjacency and recalculates the collapses of all edges around u
+		auto& u_faces = vertex_faces[u];
+		u_faces.erase(std::remove_if(u_faces.begin(), u_faces.end(), [&](unsigned f) {
+			return is_face_removed[f];
+		}), u_faces.end());
+		std::vector<unsigned> neighbors;
+
+		for (unsigned f : u_faces) {
+			for (int i = 0; i < 3; ++i) {
+				if (triangles[f][i] != u) {
+					neighbors.push_back(triangles[f][i]);
+				}
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+		for (unsigned neighbor : neighbors) {
+			push_collapse(u, neighbor);
+		}
+	}
+	std::vector<MeshTriangle> simplified;
+	simplified.reserve(face_count);
+
+	for (unsigned f = 0; f < triangles.size(); ++f) {
+		if (is_face_removed[f]) {
+			continue;
+		}
+		glm::uvec3 const& t = triangles[f];
+		MeshTriangle face {glm::vec3 {positions[t[0]]}, glm::vec3 {positions[t[1]]}, glm::vec3 {positions[t[2]]}};
+		face.n = glm::normalize(glm::cross(face.v1 - face.v0, face.v2 - face.v0));
+		face.material = faces[f].material;
+		simplified.push_back(face);
+	}
+	return simplified;
+}
+
+float mean_edge_length(std::vector<MeshTriangle> const& faces) {
+	if (faces.empty()) {
+		return 0;
+	}
+	double length_sum = 0;
+
+	for (MeshTriangle const& face : faces) {
+		length_sum += glm::length(face.v1 - face.v0) + glm::length(face.v2 - face.v1) + glm::length(face.v0 - face.v2);
+	}
+	return length_sum / (3 * faces.size());
+}
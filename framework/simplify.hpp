@@ -0,0 +1,18 @@
+#ifndef RAYTRACER_SIMPLIFY_HPP
+#define RAYTRACER_SIMPLIFY_HPP
+
+#include <vector>
+#include "meshTriangle.hpp"
+
+/**
+ * Reduces the amount of triangles of a mesh by collapsing the edges with the smallest quadric error
+ * @param faces triangles of the mesh, vertices with equal positions are treated as shared
+ * @param target_count amount of triangles to stop at
+ * @return simplified triangles with flat face normals
+ */
+std::vector<MeshTriangle> simplify_mesh(std::vector<MeshTriangle> const& faces, unsigned target_count);
+
+//average length of the triangle edges, used to compare the detail of meshes to the size of a ray footprint
+float mean_edge_length(std::vector<MeshTriangle> const& faces);
+
+#endif //RAYTRACER_SIMPLIFY_HPP
@@ -19,12 +19,22 @@ float Sphere::volume() const {
 	return 4.0f / 3.0f * PI * abs(pow(radius_, 3));
 }
 
+//half size of the box around the transformed sphere, each axis reaches as far as the row of the matrix is long
+glm::vec3 transformed_extent(float radius, glm::mat4 const& transform) {
+	return radius * glm::vec3 {
+			glm::length(glm::vec3 {transform[0][0], transform[1][0], transform[2][0]}),
+			glm::length(glm::vec3 {transform[0][1], transform[1][1], transform[2][1]}),
+			glm::length(glm::vec3 {transform[0][2], transform[1][2], transform[2][2]})};
+}
+
 glm::vec3 Sphere::min(glm::mat4 const& transform) const {
-	return center_ - glm::vec3 {radius_, radius_, radius_};
+	glm::mat4 final_transform = transform * world_transform_;
+	return transform_vec(center_, final_transform) - transformed_extent(radius_, final_transform);
 }
 
 glm::vec3 Sphere::max(glm::mat4 const& transform) const {
-	return center_ + glm::vec3 {radius_, radius_, radius_};
+	glm::mat4 final_transform = transform * world_transform_;
+	return transform_vec(center_, final_transform) + transformed_extent(radius_, final_transform);
 }
 
 std::ostream& Sphere::print(std::ostream &os) const {
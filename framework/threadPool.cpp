@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "threadPool.hpp"
+
+//pool and deque of the worker running on the current thread
+thread_local ThreadPool const* current_pool = nullptr;
+thread_local unsigned current_queue = 0;
+
+//binds the calling thread to a core
+void pin_to_core(unsigned core) {
+#ifdef __linux__
+	cpu_set_t cores;
+	CPU_ZERO(&cores);
+	CPU_SET(core, &cores);
+
+	if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cores)) {
+		std::cerr << "could not pin worker to core " << core << std::endl;
+	}
+#else
+	std::cerr << "pinning worker threads is only supported on linux" << std::endl;
+#endif
+}
+
+ThreadPool::ThreadPool(unsigned thread_count) :
+		ThreadPool(PoolOptions {thread_count}) {}
+
+ThreadPool::ThreadPool(PoolOptions const& options) :
+		queued_count_{0},
+		is_stopping_{false} {
+	unsigned core_count = std::max(1u, std::thread::hardware_concurrency());
+	unsigned thread_count = 0 == options.thread_count ? core_count : options.thread_count;
+
+	for (unsigned i = 0; i <= thread_count; ++i) {
+		queues_.push_back(std::make_unique<TaskQueue>());
+	}
+	for (unsigned i = 0; i < thread_count; ++i) {
+		int core = options.pin_threads ? (options.first_core + i) % core_count : -1;
+		threads_.emplace_back(&ThreadPool::worker_function, this, i, core);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock {sleep_mutex_};
+		is_stopping_ = true;
+	}
+	task_added_.notify_all();
+
+	for (std::thread& thread : threads_) {
+		thread.join();
+	}
+}
+
+std::unique_ptr<ThreadPool>& ThreadPool::global_pool() {
+	static std::unique_ptr<ThreadPool> pool;
+	return pool;
+}
+
+std::mutex& ThreadPool::global_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+
+ThreadPool& ThreadPool::global() {
+	std::lock_guard<std::mutex> lock {global_mutex()};
+
+	if (nullptr == global_pool()) {
+		global_pool() = std::make_unique<ThreadPool>(PoolOptions {});
+	}
+	return *global_pool();
+}
+
+void ThreadPool::configure_global(PoolOptions const& options) {
+	std::lock_guard<std::mutex> lock {global_mutex()};
+	//stops the old workers before starting the new ones, so both never compete for the cores
+	global_pool() = nullptr;
+	global_pool() = std::make_unique<ThreadPool>(options);
+}
+
+void ThreadPool::restart_global_after_fork(PoolOptions const& options) {
+	//joining threads of the parent would never return
+	global_pool().release();
+	global_pool() = std::make_unique<ThreadPool>(options);
+}
+
+unsigned ThreadPool::thread_count() const {
+	return threads_.size();
+}
+
+void ThreadPool::parallel_for(unsigned first, unsigned last, unsigned grain_size, std::function<void(unsigned)> const& body) {
+	if (last - first <= std::max(1u, grain_size)) {
+		for (unsigned i = first; i < last; ++i) {
+			body(i);
+		}
+		return;
+	}
+	//forks the second half for other workers to steal and keeps working on the first one
+	unsigned middle = first + (last - first) / 2;
+	auto second_half = submit([this, middle, last, grain_size, &body]() {
+		parallel_for(middle, last, grain_size, body);
+	});
+	parallel_for(first, middle, grain_size, body);
+	wait(second_half);
+}
+
+unsigned ThreadPool::queue_index() const {
+	return this == current_pool ? current_queue : threads_.size();
+}
+
+void ThreadPool::push(std::function<void()> task) {
+	TaskQueue& queue = *queues_[queue_index()];
+	//counts the task before it can be taken, so the count never drops below zero
+	++queued_count_;
+	{
+		std::lock_guard<std::mutex> lock {queue.mutex};
+		queue.tasks.push_back(std::move(task));
+	}
+	//locks so a worker cannot miss the notification between checking the count and going to sleep
+	std::lock_guard<std::mutex> lock {sleep_mutex_};
+	task_added_.notify_one();
+}
+
+bool ThreadPool::run_queued_task() {
+	unsigned own_index = queue_index();
+	std::function<void()> task;
+
+	//takes the newest task of the own deque, otherwise steals the oldest task of another one
+	for (unsigned i = 0; i < queues_.size() && !task; ++i) {
+		unsigned index = (own_index + i) % queues_.size();
+		TaskQueue& queue = *queues_[index];
+		std::lock_guard<std::mutex> lock {queue.mutex};
+
+		if (queue.tasks.empty()) {
+			continue;
+		}
+		if (index == own_index) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		} else {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+	if (!task) {
+		return false;
+	}
+	--queued_count_;
+	task();
+	return true;
+}
+
+void ThreadPool::worker_function(unsigned index, int core) {
+	//pins the worker before it runs any task, so no task starts on another core and moves
+	if (core >= 0) {
+		pin_to_core(core);
+	}
+	current_pool = this;
+	current_queue = index;
+
+	while (true) {
+		if (run_queued_task()) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock {sleep_mutex_};
+		task_added_.wait(lock, [this]() {
+			return is_stopping_ || 0 != queued_count_;
+		});
+		if (is_stopping_ && 0 == queued_count_) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef RAYTRACER_THREADPOOL_HPP
+#define RAYTRACER_THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <chrono>
+
+struct PoolOptions {
+	//amount of worker threads, 0 uses one per hardware thread
+	unsigned thread_count = 0;
+	//binds every worker to its own core, so renders sharing a machine can be given separate cores
+	//memory is not placed on the NUMA node of the cores, it stays wherever the thread that first wrote it ran
+	bool pin_threads = false;
+	//core the first worker is bound to, the following workers take the next cores
+	unsigned first_core = 0;
+};
+
+/**
+ * Work stealing scheduler with worker threads that are started once and sleep until tasks are submitted.
+ * Every worker keeps its own deque: it runs its newest tasks first and idle workers steal the oldest ones,
+ * which are usually the biggest parts of a split up job. Threads waiting for a result help with queued
+ * tasks, so tasks can fork tasks and join them again.
+ */
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned thread_count);
+	explicit ThreadPool(PoolOptions const& options);
+	~ThreadPool();
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	//pool shared by loading, building and rendering, with one thread per hardware thread unless configured otherwise
+	static ThreadPool& global();
+
+	/**
+	 * Replaces the shared pool with one using the given options.
+	 * Must not be called while tasks of the previous pool are still running.
+	 */
+	static void configure_global(PoolOptions const& options);
+
+	/**
+	 * Gives a process forked from this one a shared pool of its own.
+	 * The threads of the previous pool only exist in the parent process, so it is left behind without being stopped.
+	 */
+	static void restart_global_after_fork(PoolOptions const& options);
+
+	unsigned thread_count() const;
+
+	/**
+	 * Queues a task on the deque of the calling worker, or on the shared deque if called from outside the pool
+	 * @return future of the value returned by the task
+	 */
+	template<typename Task>
+	auto submit(Task task) -> std::future<decltype(task())>;
+
+	//runs queued tasks on the calling thread until the future is ready, then returns its value
+	template<typename T>
+	T wait(std::future<T>& future);
+
+	/**
+	 * Calls body for every index in [first, last) by splitting the range in halves until they are small enough
+	 * @param grain_size amount of indices that are not split up further
+	 */
+	void parallel_for(unsigned first, unsigned last, unsigned grain_size, std::function<void(unsigned)> const& body);
+
+private:
+	struct TaskQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+	//one deque per worker and a last one for tasks submitted from outside the pool
+	std::vector<std::unique_ptr<TaskQueue>> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic_uint queued_count_;
+	std::mutex sleep_mutex_;
+	std::condition_variable task_added_;
+	bool is_stopping_;
+
+	void push(std::function<void()> task);
+	bool run_queued_task();
+	unsigned queue_index() const;
+	//@param core core the worker binds itself to, -1 to leave it to the scheduler
+	void worker_function(unsigned index, int core);
+	static std::unique_ptr<ThreadPool>& global_pool();
+	//guards replacing the shared pool
+	static std::mutex& global_mutex();
+};
+
+template<typename Task>
+auto ThreadPool::submit(Task task) -> std::future<decltype(task())> {
+	auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+	auto future = packaged->get_future();
+	push([packaged]() { (*packaged)(); });
+	return future;
+}
+
+template<typename T>
+T ThreadPool::wait(std::future<T>& future) {
+	while (std::future_status::ready != future.wait_for(std::chrono::seconds(0))) {
+		//sleeps shortly if another thread is busy with the awaited task and nothing else is queued
+		if (!run_queued_task()) {
+			future.wait_for(std::chrono::microseconds(100));
+		}
+	}
+	return future.get();
+}
+
+#endif //RAYTRACER_THREADPOOL_HPP
@@ -1,3 +1,4 @@
+#include <limits>
 #include "triangle.hpp"
 
 #define EPSILON 0.001f
@@ -86,3 +87,36 @@ HitPoint Triangle::intersect(Ray const& ray) const {
 		return {true, t, name_, material_, ray.point(t), ray_inv.direction, transform_vec(n_, world_transform_, false)};
 	}
 }
+
+void Triangle::intersect_packet(RayPacket const& packet, HitPoint* hits) const {
+	//triangles with an own transformation are rare, they are intersected ray by ray
+	if (glm::mat4() != world_transform_) {
+		Shape::intersect_packet(packet, hits);
+		return;
+	}
+	glm::vec3 v0v1 = v1_ - v0_;
+	glm::vec3 v0v2 = v2_ - v0_;
+	float ts[PACKET_SIZE];
+
+	//tests all rays against the same edges without branching, so the loop can be vectorized
+	for (unsigned i = 0; i < packet.size; ++i) {
+		Ray const& ray = packet.rays[i];
+		glm::vec3 p_vec = glm::cross(ray.direction, v0v2);
+		float det = glm::dot(v0v1, p_vec);
+		float inv_det = 1 / det;
+		glm::vec3 t_vec = ray.origin - v0_;
+		float u = glm::dot(t_vec, p_vec) * inv_det;
+		glm::vec3 q_vec = glm::cross(t_vec, v0v1);
+		float v = glm::dot(ray.direction, q_vec) * inv_det;
+		float t = glm::dot(v0v2, q_vec) * inv_det;
+		bool is_hit = (det >= EPSILON || det <= -EPSILON) && u >= 0 && u <= 1 && v >= 0 && u + v <= 1 && t >= EPSILON;
+		ts[i] = is_hit ? t - EPSILON : std::numeric_limits<float>::infinity();
+	}
+	for (unsigned i = 0; i < packet.size; ++i) {
+		if (!packet.is_active(i) || std::numeric_limits<float>::infinity() == ts[i] || (hits[i].does_intersect && ts[i] >= hits[i].distance)) {
+			continue;
+		}
+		Ray const& ray = packet.rays[i];
+		hits[i] = {true, ts[i], name_, material_, ray.point(ts[i]), ray.direction, n_};
+	}
+}
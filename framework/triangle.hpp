@@ -26,6 +26,7 @@ public:
 
 	std::ostream& print (std::ostream &os) const override;
 	HitPoint intersect(Ray const& ray) const override;
+	void intersect_packet(RayPacket const& packet, HitPoint* hits) const override;
 
 private:
 	glm::vec3 v0_;
@@ -6,19 +6,39 @@
 
 #include "scene.hpp"
 #include "renderer.hpp"
+#include "animation.hpp"
+#include "distributed.hpp"
 
+//arguments: [scene file] [worker processes, 0 renders with the threads of this process]
 int main(int argc, const char** argv) {
 	unsigned img_width = 800;
 	unsigned img_height = img_width;
+	unsigned worker_count = argc > 2 ? std::stoul(argv[2]) : 0;
 
-	Scene scene = load_scene("../../sdf/cornell.sdf");
-	Renderer renderer{img_width, img_height, "../../sdf/img.ppm", 2, 5};
+	Scene scene = load_scene(argc > 1 ? argv[1] : "../../sdf/cornell.sdf");
 	std::cout << "shapes " << scene.root->child_count() << "\n";
 	std::cout << "lights " << scene.lights.size() << "\n";
 
+	//scenes with render commands are rendered as a batch of frames without opening a window
+	if (!scene.render_commands.empty()) {
+		for (RenderCommand const& command : scene.render_commands) {
+			Renderer renderer{command.width, command.height, command.file_name, 2, 5};
+			render_animation(renderer, scene, command);
+		}
+		return 0;
+	}
+	Renderer renderer{img_width, img_height, "../../sdf/img.ppm", 2, 5};
+
 	try {
 		auto start = std::chrono::steady_clock::now();
-		renderer.render(scene);
+
+		if (worker_count > 0) {
+			DistributedOptions options;
+			options.worker_count = worker_count;
+			render_distributed(renderer, scene, options);
+		} else {
+			renderer.render(scene);
+		}
 		auto end = std::chrono::steady_clock::now();
 		std::chrono::duration<double> elapsed_seconds = end-start;
 		std::cout << elapsed_seconds.count() << "s\n";
@@ -6,15 +6,44 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/intersect.hpp>
 #include <string>
+#include <fstream>
+#include <filesystem>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 #include "renderer.hpp"
+#include "distributed.hpp"
+#include "animation.hpp"
 #include "sphere.hpp"
 #include "box.hpp"
 #include "triangle.hpp"
 #include "scene.hpp"
+#include "simplify.hpp"
 
 #define PI 3.14159265f
 
+//file in the temporary directory that is removed when the test ends, also if a requirement fails
+struct TempFile {
+	std::string path;
+
+	explicit TempFile(std::string const& name) :
+			path{(std::filesystem::temp_directory_path() / ("raytracer_" + name)).string()} {
+		//a test that crashed before may have left the file behind
+		std::error_code error;
+		std::filesystem::remove(path, error);
+	}
+	~TempFile() {
+		std::error_code error;
+		std::filesystem::remove(path, error);
+	}
+	TempFile(TempFile&& other) noexcept : path{std::move(other.path)} {
+		other.path.clear();
+	}
+	TempFile(TempFile const&) = delete;
+	TempFile& operator=(TempFile const&) = delete;
+};
+
 //Aufgabe 5.2
 TEST_CASE("create a sphere", "[geometry]") {
 	Sphere s0{1};
@@ -175,6 +204,162 @@ TEST_CASE("composite_ray_intersection", "[intersect]") {
 	REQUIRE("back" == hit0.hit_object);
 }
 
+TEST_CASE("flattened_composite_ray_intersection", "[intersect]") {
+	auto group = std::make_shared<Composite>("group");
+	group->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -1}, "back"}));
+	auto moved = std::make_shared<Composite>("moved");
+	moved->add_child(std::make_shared<Box>(Box {{-1, -1, 0}, {1, 1, 2}, "front"}));
+	moved->translate(5, 0, 0);
+
+	Composite comp {"root"};
+	comp.add_child(group);
+	comp.add_child(moved);
+	comp.flatten();
+
+	HitPoint hit0 = comp.intersect({{0, 10, -1}, {0, -1, 0}});
+	REQUIRE("back" == hit0.hit_object);
+	REQUIRE(1 == Approx(hit0.position.y).margin(0.01));
+
+	HitPoint hit1 = comp.intersect({{5, 10, 1}, {0, -1, 0}});
+	REQUIRE("front" == hit1.hit_object);
+	REQUIRE(1 == Approx(hit1.position.y).margin(0.01));
+	REQUIRE(false == comp.intersect({{0, 10, 1}, {0, -1, 0}}).does_intersect);
+}
+
+TEST_CASE("instance_ray_intersection", "[intersect]") {
+	auto box = std::make_shared<Box>(Box {{-1, -1, -1}, {1, 1, 1}, "box"});
+	Instance instance {box, "moved_box"};
+	instance.translate(5, 0, 0);
+
+	HitPoint hit0 = instance.intersect({{5, 10, 0}, {0, -1, 0}});
+	REQUIRE(true == hit0.does_intersect);
+	REQUIRE(1 == Approx(hit0.position.y).margin(0.01));
+	REQUIRE(glm::vec3{0, 1, 0} == hit0.surface_normal);
+
+	HitPoint hit1 = instance.intersect({{0, 10, 0}, {0, -1, 0}});
+	REQUIRE(false == hit1.does_intersect);
+}
+
+TEST_CASE("quad_ray_intersection", "[intersect]") {
+	//kite shaped so that the far corner lies outside the parallelogram spanned by the edges at v0
+	Quad quad {{0, 0, 0}, {0, 0, 2}, {3, 0, 3}, {2, 0, 0}};
+	REQUIRE(1 == Approx(quad.intersect({{2.5f, 10, 2.5f}, {0, -1, 0}}).surface_normal.y).margin(0.001));
+	REQUIRE(true == quad.intersect({{0.5f, 10, 0.5f}, {0, -1, 0}}).does_intersect);
+	REQUIRE(false == quad.intersect({{2.9f, 10, 2}, {0, -1, 0}}).does_intersect);
+	REQUIRE(false == quad.intersect({{-0.5f, 10, 1}, {0, -1, 0}}).does_intersect);
+
+	std::vector<glm::vec3> vertices {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}, {0, 1, 1}, {-1, 0, 0}};
+	std::vector<MeshTriangle> triangles;
+	std::vector<MeshQuad> quads;
+	std::istringstream flat_quad("1 4 3 2");
+	std::istringstream bent_quad("1 2 3 5");
+	std::istringstream pentagon("1//1 6 4 3 2");
+	load_obj_face(flat_quad, vertices, {}, nullptr, triangles, quads);
+	load_obj_face(bent_quad, vertices, {}, nullptr, triangles, quads);
+	load_obj_face(pentagon, vertices, {{0, 1, 0}}, nullptr, triangles, quads);
+	REQUIRE(1 == quads.size());
+	REQUIRE(1 == Approx(quads[0].n.y).margin(0.001));
+	REQUIRE(5 == triangles.size());
+}
+
+TEST_CASE("packet_ray_intersection", "[intersect]") {
+	MeshTriangle face {{-1, 0, -1}, {0, 0, 1}, {1, 0, -1}, {0, 1, 0}};
+	auto mesh = std::make_shared<CompressedMesh>(std::vector<MeshTriangle> {face});
+	auto instance = std::make_shared<Instance>(mesh, "moved_mesh");
+	instance->translate(0, 2, 0);
+
+	Composite comp {"root"};
+	comp.add_child(instance);
+	comp.add_child(std::make_shared<Triangle>(glm::vec3 {-4, 0, -4}, glm::vec3 {-4, 0, 4}, glm::vec3 {4, 0, 0}));
+	comp.add_child(std::make_shared<Sphere>(Sphere {0.5f, {3, 0, 3}, "ball"}));
+	comp.flatten();
+
+	//rays from a common origin that hit each shape, hit shapes behind each other and miss everything
+	RayPacket packet {};
+	for (int x = 0; x < 4; ++x) {
+		for (int z = 0; z < 4; ++z) {
+			packet.add({{0, 10, 0}, glm::normalize(glm::vec3 {x - 0.5f, -3, z - 0.5f})});
+		}
+	}
+	HitPoint hits[PACKET_SIZE];
+	comp.intersect_packet(packet, hits);
+
+	for (unsigned i = 0; i < packet.size; ++i) {
+		HitPoint hit = comp.intersect(packet.rays[i]);
+		REQUIRE(hit.does_intersect == hits[i].does_intersect);
+		REQUIRE(hit.hit_object == hits[i].hit_object);
+		REQUIRE(hit.distance == Approx(hits[i].distance));
+		REQUIRE(hit.surface_normal.y == Approx(hits[i].surface_normal.y));
+	}
+}
+
+TEST_CASE("compressed_mesh_ray_intersection", "[intersect]") {
+	MeshTriangle face {{-1, 0, -1}, {0, 0, 1}, {1, 0, -1}, {0, 1, 0}};
+	MeshTriangle other_face {{-1, 5, -1}, {0, 5, 1}, {1, 5, -1}, glm::normalize(glm::vec3{1, -1, -1})};
+	CompressedMesh mesh {{face, other_face}};
+	Triangle triangle {face.v0, face.v1, face.v2, face.n};
+	REQUIRE(2 == mesh.triangle_count());
+
+	HitPoint hit0 = mesh.intersect(Ray {{0, -10, 0}, {0, 1, 0}});
+	HitPoint expected0 = triangle.intersect(Ray {{0, -10, 0}, {0, 1, 0}});
+	REQUIRE(true == hit0.does_intersect);
+	REQUIRE(expected0.distance == Approx(hit0.distance).margin(0.001));
+	REQUIRE(0 == Approx(hit0.surface_normal.x).margin(0.001));
+	REQUIRE(1 == Approx(hit0.surface_normal.y).margin(0.001));
+
+	//finds the closer face and decodes a normal folded over from the lower hemisphere
+	HitPoint hit1 = mesh.intersect(Ray {{0, 10, 0}, {0, -1, 0}});
+	REQUIRE(true == hit1.does_intersect);
+	REQUIRE(5 == Approx(hit1.position.y).margin(0.01));
+	REQUIRE(other_face.n.z == Approx(hit1.surface_normal.z).margin(0.001));
+
+	HitPoint hit2 = mesh.intersect(Ray {{1, 10, 1}, {0, -1, 0}});
+	REQUIRE(false == hit2.does_intersect);
+}
+
+TEST_CASE("share_obj_assets", "[sdf]") {
+	Scene scene{};
+	std::istringstream sword0("shape obj sword sword0");
+	std::istringstream sword1("shape obj sword sword1");
+	add_to_scene(sword0, scene);
+	add_to_scene(sword1, scene);
+	REQUIRE(1 == scene.assets.size());
+
+	auto instance0 = std::dynamic_pointer_cast<Instance>(scene.root->find_child("sword0"));
+	auto instance1 = std::dynamic_pointer_cast<Instance>(scene.root->find_child("sword1"));
+	REQUIRE(nullptr != instance0);
+	REQUIRE(instance0->shape() == instance1->shape());
+}
+
+TEST_CASE("simplify_lod_mesh", "[lod]") {
+	std::vector<MeshTriangle> grid;
+
+	for (int x = 0; x < 16; ++x) {
+		for (int z = 0; z < 16; ++z) {
+			glm::vec3 corner {x, 0, z};
+			grid.push_back({corner, corner + glm::vec3 {0, 0, 1}, corner + glm::vec3 {1, 0, 0}, {0, 1, 0}});
+			grid.push_back({corner + glm::vec3 {1, 0, 0}, corner + glm::vec3 {0, 0, 1}, corner + glm::vec3 {1, 0, 1}, {0, 1, 0}});
+		}
+	}
+	//a flat plane can be simplified without changing its shape
+	std::vector<MeshTriangle> simplified = simplify_mesh(grid, 32);
+	REQUIRE(32 >= simplified.size());
+	float area = 0;
+
+	for (MeshTriangle const& face : simplified) {
+		REQUIRE(1 == Approx(face.n.y).margin(0.001));
+		area += glm::length(glm::cross(face.v1 - face.v0, face.v2 - face.v0)) / 2;
+	}
+	REQUIRE(256 == Approx(area).margin(0.01));
+
+	LodMesh mesh {{std::make_shared<CompressedMesh>(grid), std::make_shared<CompressedMesh>(simplified)},
+	              {mean_edge_length(grid), mean_edge_length(simplified)}, "grid"};
+	float footprint;
+	REQUIRE(0 == mesh.select_level(Ray {{8, 10, 8}, {0, -1, 0}}, footprint));
+	REQUIRE(1 == mesh.select_level(Ray {{8, 10, 8}, {0, -1, 0}, 0, 1}, footprint));
+	REQUIRE(true == mesh.intersect(Ray {{8, 10, 8}, {0, -1, 0}, 0, 1}).does_intersect);
+}
+
 TEST_CASE("box_ray_intersection_speed", "[intersect]") {
 	Box box{{0, 0, 0}, {1, 1, 1}};
 	Ray ray{{0.5f, 0.5f, -10}, {0, 0, 1}};
@@ -189,6 +374,635 @@ TEST_CASE("box_ray_intersection_speed", "[intersect]") {
 	std::cout << range << " intersections take " << elapsed_seconds.count() << "s\n";
 }
 
+TEST_CASE("thread_pool", "[threads]") {
+	ThreadPool pool {2};
+	//tasks can wait for tasks they submitted themselves without blocking the workers
+	auto outer = pool.submit([&pool]() {
+		auto inner = pool.submit([]() {
+			return 20;
+		});
+		return pool.wait(inner) + 1;
+	});
+	REQUIRE(21 == pool.wait(outer));
+
+	//nested parallel loops fork and join inside each other
+	std::vector<unsigned> counts(100, 0);
+	pool.parallel_for(0, 10, 1, [&pool, &counts](unsigned i) {
+		pool.parallel_for(10 * i, 10 * i + 10, 3, [&counts](unsigned j) {
+			++counts[j];
+		});
+	});
+	REQUIRE(std::vector<unsigned>(100, 1) == counts);
+
+	ThreadPool::configure_global({2, true});
+	REQUIRE(2 == ThreadPool::global().thread_count());
+	std::atomic_uint sum {0};
+	ThreadPool::global().parallel_for(0, 100, 8, [&sum](unsigned i) {
+		sum += i;
+	});
+	REQUIRE(4950 == sum);
+	ThreadPool::configure_global({});
+
+#ifdef __linux__
+	//a pinned worker runs even its first task on its core, the future is not waited for in the pool so no other thread helps
+	ThreadPool pinned {PoolOptions {1, true, 0}};
+	auto core = pinned.submit([]() {
+		return sched_getcpu();
+	});
+	REQUIRE(0 == core.get());
+#endif
+}
+
+TEST_CASE("tile_rendering", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile image {"tiles.ppm"};
+	//tiles that do not divide the image evenly still cover every pixel once
+	Renderer single {21, 13, image.path, 1, 0, 1};
+	Renderer tiled {21, 13, image.path, 1, 0, 8};
+	single.render(scene);
+	tiled.render(scene);
+
+	for (unsigned i = 0; i < 21 * 13; ++i) {
+		REQUIRE(single.color_buffer()[i].r == tiled.color_buffer()[i].r);
+	}
+	REQUIRE(tiled.color_buffer()[0].r != tiled.color_buffer()[6 * 21 + 10].r);
+}
+
+TEST_CASE("wavefront_rendering", "[render]") {
+	auto mirror = std::make_shared<Material>();
+	mirror->ks = {1, 1, 1};
+	mirror->glossy = 0.8f;
+	auto glass = std::make_shared<Material>();
+	glass->kd = {1, 1, 1};
+	glass->opacity = 0.2f;
+	glass->ior = 1.5f;
+
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {-1, 0, -5}, "mirror", mirror}));
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {1, 0, -4}, "glass", glass}));
+	scene.root->add_child(std::make_shared<Box>(Box {{-5, -2, -10}, {5, -1, 0}, "floor", std::make_shared<Material>()}));
+	scene.lights.push_back({"sun", {1, 1, 1}, {0, 5, 0}});
+	scene.root->flatten();
+
+	//tracing the rays bounce by bounce adds up the same light as tracing them one after another
+	TempFile image {"wavefront.ppm"};
+	Renderer recursive {24, 16, image.path, 2, 3, 8, RenderMode::recursive};
+	Renderer wavefront {24, 16, image.path, 2, 3, 8, RenderMode::wavefront};
+	recursive.render(scene);
+	wavefront.render(scene);
+
+	for (unsigned i = 0; i < 24 * 16; ++i) {
+		REQUIRE(recursive.color_buffer()[i].r == Approx(wavefront.color_buffer()[i].r).margin(0.0001));
+		REQUIRE(recursive.color_buffer()[i].b == Approx(wavefront.color_buffer()[i].b).margin(0.0001));
+	}
+}
+
+TEST_CASE("ray_queue_sorting", "[render]") {
+	RayQueue queue;
+
+	for (unsigned i = 0; i < 64; ++i) {
+		glm::vec3 dir {i % 2 ? 1 : -1, i % 3 ? 1 : -1, i % 5 ? 1 : -1};
+		queue.push({{i % 8, 0, i / 8}, dir}, {1, 1, 1}, i, 0);
+	}
+	queue.sort();
+	REQUIRE(64 == queue.size());
+
+	//rays end up grouped by the way they head
+	std::set<unsigned> pixels;
+	unsigned direction_changes = 0;
+
+	for (unsigned i = 0; i < queue.size(); ++i) {
+		pixels.insert(queue.pixels[i]);
+		REQUIRE(queue.origins[i] == glm::vec3 {queue.pixels[i] % 8, 0, queue.pixels[i] / 8});
+
+		if (i > 0 && queue.directions[i] != queue.directions[i - 1]) {
+			++direction_changes;
+		}
+	}
+	REQUIRE(64 == pixels.size());
+	REQUIRE(7 == direction_changes);
+}
+
+TEST_CASE("ray_pruning", "[render]") {
+	auto glass = std::make_shared<Material>();
+	glass->ks = {1, 1, 1};
+	glass->kd = {1, 1, 1};
+	glass->glossy = 0.5f;
+	glass->opacity = 0.5f;
+	glass->ior = 1.5f;
+
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {-0.5f, 0, -5}, "front", glass}));
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0.5f, 0, -7}, "back", glass}));
+	scene.lights.push_back({"sun", {1, 1, 1}, {0, 5, 0}});
+	scene.root->flatten();
+
+	TempFile image {"pruning.ppm"};
+	Renderer full {16, 16, image.path, 1, 8};
+	Renderer pruned {16, 16, image.path, 1, 8};
+	Renderer roulette {16, 16, image.path, 1, 8};
+	pruned.set_pruning(0.001f);
+	roulette.set_pruning(0.05f, true);
+	full.render(scene);
+	pruned.render(scene);
+	roulette.render(scene);
+
+	//dropping rays that add less than a thousandth of their sample hardly changes the image
+	float full_sum = 0;
+	float roulette_sum = 0;
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		REQUIRE(full.color_buffer()[i].r == Approx(pruned.color_buffer()[i].r).margin(0.002));
+		full_sum += full.color_buffer()[i].r;
+		roulette_sum += roulette.color_buffer()[i].r;
+	}
+	REQUIRE(full_sum > 0);
+	REQUIRE(roulette_sum == Approx(full_sum).epsilon(0.05));
+}
+
+TEST_CASE("adaptive_anti_aliasing", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile image {"adaptive.ppm"};
+	Renderer full {32, 32, image.path, 4, 0};
+	Renderer adaptive {32, 32, image.path, 4, 0};
+	adaptive.set_adaptive_aa(true);
+	full.render(scene);
+	adaptive.render(scene);
+
+	//only pixels at the outline of the ball get the full grid of samples, the others one sample that is close to it
+	unsigned equal_pixels = 0;
+
+	for (unsigned i = 0; i < 32 * 32; ++i) {
+		REQUIRE(full.color_buffer()[i].r == Approx(adaptive.color_buffer()[i].r).margin(0.03));
+
+		if (full.color_buffer()[i].r == adaptive.color_buffer()[i].r && 0 != full.color_buffer()[i].r) {
+			++equal_pixels;
+		}
+	}
+	REQUIRE(equal_pixels > 0);
+	REQUIRE(0 == adaptive.color_buffer()[0].r);
+}
+
+TEST_CASE("progressive_rendering", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile image {"progressive.ppm"};
+	Renderer full {16, 16, image.path, 4, 0};
+	Renderer progressive {16, 16, image.path, 4, 0};
+	full.render(scene);
+	progressive.render_progressive(scene, {0, 16});
+	REQUIRE(16 == progressive.sample_count());
+	REQUIRE(progressive.noise() > 0);
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		REQUIRE(full.color_buffer()[i].r == Approx(progressive.color_buffer()[i].r).margin(0.1));
+	}
+	//a tiny time budget still finishes the first pass, a loose noise target needs two passes to measure any noise
+	progressive.render_progressive(scene, {0.000001});
+	REQUIRE(1 == progressive.sample_count());
+	progressive.render_progressive(scene, {0, 0, 1});
+	REQUIRE(2 == progressive.sample_count());
+	progressive.render_progressive(scene, {});
+	REQUIRE(16 == progressive.sample_count());
+}
+
+TEST_CASE("sample_generators", "[render]") {
+	GridSampler grid {2};
+	REQUIRE(glm::vec2 {0.5f, 0} == grid.sample(3, 7, 2));
+	REQUIRE(grid.sample(3, 7, 1) == grid.sample(3, 7, 5));
+
+	for (SamplerType type : {SamplerType::stratified, SamplerType::halton, SamplerType::sobol, SamplerType::blue_noise}) {
+		auto sampler = make_sampler(type, 4);
+
+		//stratified and Sobol samples fill every cell of a 4x4 grid with their first 16 samples, shifted sequences a shifted grid
+		for (unsigned pixel = 0; pixel < 3; ++pixel) {
+			std::set<unsigned> cells;
+
+			for (unsigned i = 0; i < 16; ++i) {
+				glm::vec2 sample = sampler->sample(pixel, 2 * pixel, i, pixel);
+				REQUIRE(sample == sampler->sample(pixel, 2 * pixel, i, pixel));
+				REQUIRE((sample.x >= 0 && sample.x < 1 && sample.y >= 0 && sample.y < 1));
+				cells.insert(unsigned (sample.x * 4) * 4 + unsigned (sample.y * 4));
+			}
+			if (SamplerType::stratified == type || SamplerType::sobol == type) {
+				REQUIRE(16 == cells.size());
+			}
+		}
+		REQUIRE(sampler->sample(0, 0, 0) != sampler->sample(1, 0, 0));
+	}
+}
+
+TEST_CASE("path_tracing", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({"bulb", {1, 1, 1}, {0, 3, -3}, 8});
+	scene.ambient.intensity = {};
+	scene.root->flatten();
+
+	//without bounces a point light lights a path the same as Phong shading without ambient light
+	TempFile image {"path.ppm"};
+	Renderer whitted {16, 16, image.path, 2, 0};
+	Renderer path {16, 16, image.path, 2, 0};
+	path.set_integrator(Integrator::path_tracing);
+	whitted.render(scene);
+	path.render(scene);
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		REQUIRE(whitted.color_buffer()[i].r == Approx(path.color_buffer()[i].r));
+	}
+	//sampling a small light sphere converges to the light of a point that falls off with the squared distance
+	scene.lights.back().radius = 0.2f;
+	whitted.set_sampler(make_sampler(SamplerType::sobol, 2));
+	path.set_sampler(make_sampler(SamplerType::sobol, 2));
+	whitted.render_progressive(scene, {0, 64});
+	path.render_progressive(scene, {0, 64});
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		REQUIRE(whitted.color_buffer()[i].r == Approx(path.color_buffer()[i].r).margin(0.05));
+	}
+	//a point light is as bright as a light sphere shrunk to a point
+	scene.lights.back().radius = 0;
+	path.render(scene);
+	std::vector<Color> point_light = path.color_buffer();
+	scene.lights.back().radius = 0.001f;
+	path.render(scene);
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		REQUIRE(point_light[i].r == Approx(path.color_buffer()[i].r).margin(0.01));
+	}
+}
+
+TEST_CASE("denoising", "[render]") {
+	unsigned size = 32;
+	std::vector<Color> colors(size * size);
+	std::vector<GuideSample> guides(size * size);
+
+	//the left half of the image faces another way and is darker than the right half, both are noisy
+	for (unsigned i = 0; i < size * size; ++i) {
+		bool is_left = i % size < size / 2;
+		float noise = (hash_bits(i) % 1000) / 1000.0f - 0.5f;
+		guides[i] = {{0.5f, 0.5f, 0.5f}, is_left ? glm::vec3 {1, 0, 0} : glm::vec3 {0, 1, 0}, 5};
+		colors[i] = Color {1, 1, 1} * ((is_left ? 0.2f : 1.0f) + noise * 0.4f);
+	}
+	float noisy_error = 0;
+	float denoised_error = 0;
+	std::vector<Color> denoised = colors;
+	denoise(denoised, guides, size, size);
+
+	for (unsigned i = 0; i < size * size; ++i) {
+		float expected = i % size < size / 2 ? 0.2f : 1.0f;
+		noisy_error += std::abs(colors[i].r - expected);
+		denoised_error += std::abs(denoised[i].r - expected);
+	}
+	REQUIRE(denoised_error < noisy_error * 0.25f);
+	//the edge between the halves does not get blurred
+	REQUIRE(denoised[size * size / 2 + size / 2 - 1].r == Approx(0.2f).margin(0.1));
+	REQUIRE(denoised[size * size / 2 + size / 2].r == Approx(1.0f).margin(0.1));
+}
+
+TEST_CASE("reduced_pixel_patterns", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile image {"reduced.ppm"};
+	Renderer full {16, 16, image.path, 2, 0};
+	Renderer half {16, 16, image.path, 2, 0};
+	Renderer checkerboard {16, 16, image.path, 2, 0};
+	half.set_pixel_pattern(PixelPattern::half_resolution);
+	checkerboard.set_pixel_pattern(PixelPattern::checkerboard);
+	full.render(scene);
+	half.render(scene);
+
+	//traced pixels are the same as in a full render, the others are close to them except at some edges
+	unsigned close_count = 0;
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		if (0 == i % 2 && 0 == (i / 16) % 2) {
+			REQUIRE(full.color_buffer()[i].r == half.color_buffer()[i].r);
+		}
+		close_count += std::abs(full.color_buffer()[i].r - half.color_buffer()[i].r) < 0.1f;
+	}
+	REQUIRE(close_count > 16 * 16 * 0.9f);
+	//two checkerboard frames of a still image trace every pixel once
+	checkerboard.render(scene);
+	checkerboard.set_frame(1);
+	checkerboard.render(scene);
+	unsigned equal_count = 0;
+
+	for (unsigned i = 0; i < 16 * 16; ++i) {
+		equal_count += full.color_buffer()[i].r == checkerboard.color_buffer()[i].r;
+	}
+	REQUIRE(equal_count > 16 * 16 * 0.9f);
+}
+
+TEST_CASE("region_rendering", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile full_image {"regions_full.ppm"};
+	TempFile regions_image {"regions.ppm"};
+	TempFile crop_image {"regions_crop.ppm"};
+	Renderer full {32, 32, full_image.path, 2, 0, 8};
+	Renderer regions {32, 32, regions_image.path, 2, 0, 8};
+	full.render(scene);
+	full.save_crop(crop_image.path, {4, 4, 20, 12});
+	//the rectangles overlap each other and the borders of the tiles
+	regions.render(scene, {{4, 4, 20, 12}, {10, 6, 31, 30}});
+
+	for (unsigned y = 0; y < 32; ++y) {
+		for (unsigned x = 0; x < 32; ++x) {
+			bool is_inside = (x >= 4 && x < 20 && y >= 4 && y < 12) || (x >= 10 && x < 31 && y >= 6 && y < 30);
+			float expected = is_inside ? full.color_buffer()[y * 32 + x].r : 0;
+			REQUIRE(expected == regions.color_buffer()[y * 32 + x].r);
+		}
+	}
+	//composites the regions into the image saved before
+	REQUIRE(regions.load_image(full_image.path));
+	regions.render(scene, {{0, 0, 8, 8}});
+	REQUIRE(full.color_buffer()[3 * 32 + 3].r == regions.color_buffer()[3 * 32 + 3].r);
+	REQUIRE(full.color_buffer()[16 * 32 + 16].r == Approx(regions.color_buffer()[16 * 32 + 16].r).margin(1.0f / 255));
+
+	Renderer crop {16, 8, crop_image.path, 2, 0};
+	REQUIRE(crop.load_image(crop_image.path));
+	REQUIRE(full.color_buffer()[5 * 32 + 6].r == Approx(crop.color_buffer()[16 + 2].r).margin(1.0f / 255));
+	REQUIRE_FALSE(crop.load_image(full_image.path));
+}
+
+TEST_CASE("async_rendering", "[render]") {
+	Scene scene{};
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+	scene.lights.push_back({});
+	scene.root->flatten();
+
+	TempFile image {"async.ppm"};
+	Renderer blocking {64, 64, image.path, 2, 0, 8};
+	Renderer async {64, 64, image.path, 2, 0, 8};
+	unsigned tile_calls = 0;
+	RenderProgress last_progress;
+	blocking.render(scene);
+	auto job = async.render_async(scene, {
+			[&](RenderProgress const& progress) { last_progress = progress; },
+			[&](PixelRect const&) { ++tile_calls; }});
+	job->wait();
+
+	REQUIRE(job->is_finished());
+	REQUIRE(64 == tile_calls);
+	REQUIRE(64 == last_progress.finished_tiles);
+	RenderProgress progress = job->progress();
+	REQUIRE(64 == progress.tile_count);
+	REQUIRE(64 * 64 * 4 == progress.rays);
+	REQUIRE(0 == progress.remaining_seconds);
+
+	for (unsigned i = 0; i < 64 * 64; ++i) {
+		REQUIRE(blocking.color_buffer()[i].r == async.color_buffer()[i].r);
+	}
+
+	//cancels the render as soon as the first tile is finished, the tiles started by other threads still finish
+	std::promise<RenderJob*> job_promise;
+	std::shared_future<RenderJob*> job_future = job_promise.get_future().share();
+	job = async.render_async(scene, {{}, [job_future](PixelRect const&) { job_future.get()->cancel(); }});
+	job_promise.set_value(job.get());
+	job->wait();
+
+	REQUIRE(job->is_cancelled());
+	REQUIRE(job->progress().finished_tiles <= ThreadPool::global().thread_count() + 1);
+
+	//a second job of the same renderer waits for the first one instead of writing the same buffers
+	auto first_job = async.render_async(scene);
+	auto second_job = async.render_async(scene);
+	first_job->wait();
+	second_job->wait();
+	REQUIRE_FALSE(second_job->is_cancelled());
+
+	for (unsigned i = 0; i < 64 * 64; ++i) {
+		REQUIRE(blocking.color_buffer()[i].r == async.color_buffer()[i].r);
+	}
+}
+
+TEST_CASE("checkpoint_resume", "[render]") {
+	//the inner ball is hidden inside the other one and can be moved without changing the bounds of the scene
+	auto make_scene = [](glm::vec3 const& inner_center) {
+		Scene scene{};
+		scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {0, 0, -5}, "ball", std::make_shared<Material>()}));
+		scene.root->add_child(std::make_shared<Sphere>(Sphere {0.5f, inner_center, "inner", std::make_shared<Material>()}));
+		scene.lights.push_back({});
+		scene.root->flatten();
+		return scene;
+	};
+	Scene scene = make_scene({0, 0, -5});
+
+	TempFile full_image {"resume_full.ppm"};
+	TempFile resumed_image {"resume.ppm"};
+	TempFile checkpoint_file {"resume.checkpoint"};
+	Renderer full {64, 64, full_image.path, 2, 0, 8};
+	Renderer interrupted {64, 64, resumed_image.path, 2, 0, 8};
+	Renderer resumed {64, 64, resumed_image.path, 2, 0, 8};
+	interrupted.set_checkpoint(checkpoint_file.path);
+	resumed.set_checkpoint(checkpoint_file.path);
+	full.render(scene);
+
+	//a cancelled render saves the tiles it finished
+	std::promise<RenderJob*> job_promise;
+	std::shared_future<RenderJob*> job_future = job_promise.get_future().share();
+	auto job = interrupted.render_async(scene, {{}, [job_future](PixelRect const&) { job_future.get()->cancel(); }});
+	job_promise.set_value(job.get());
+	job->wait();
+	unsigned finished_tiles = job->progress().finished_tiles;
+
+	Checkpoint checkpoint;
+	REQUIRE(load_checkpoint(checkpoint_file.path, checkpoint));
+	REQUIRE(64 == checkpoint.rects.size());
+	REQUIRE(finished_tiles == std::count(checkpoint.finished_tiles.begin(), checkpoint.finished_tiles.end(), 1));
+
+	//the next render only renders the other tiles and removes the checkpoint when it is done
+	job = resumed.render_async(scene);
+	job->wait();
+	REQUIRE(64 - finished_tiles == job->progress().tile_count);
+	REQUIRE_FALSE(load_checkpoint(checkpoint_file.path, checkpoint));
+
+	for (unsigned i = 0; i < 64 * 64; ++i) {
+		REQUIRE(full.color_buffer()[i].r == resumed.color_buffer()[i].r);
+	}
+
+	//a render of another frame starts over instead of resuming the tiles of this one
+	std::promise<RenderJob*> second_promise;
+	std::shared_future<RenderJob*> second_future = second_promise.get_future().share();
+	job = interrupted.render_async(scene, {{}, [second_future](PixelRect const&) { second_future.get()->cancel(); }});
+	second_promise.set_value(job.get());
+	job->wait();
+	REQUIRE(load_checkpoint(checkpoint_file.path, checkpoint));
+
+	resumed.set_frame(1);
+	job = resumed.render_async(scene);
+	job->wait();
+	REQUIRE(64 == job->progress().tile_count);
+
+	//so does a render of the scene with a shape moved inside its bounds
+	std::promise<RenderJob*> third_promise;
+	std::shared_future<RenderJob*> third_future = third_promise.get_future().share();
+	job = interrupted.render_async(scene, {{}, [third_future](PixelRect const&) { third_future.get()->cancel(); }});
+	third_promise.set_value(job.get());
+	job->wait();
+	REQUIRE(load_checkpoint(checkpoint_file.path, checkpoint));
+
+	Scene moved = make_scene({0.2f, 0, -5});
+	resumed.set_frame(0);
+	job = resumed.render_async(moved);
+	job->wait();
+	REQUIRE(64 == job->progress().tile_count);
+}
+
+TEST_CASE("deterministic_rendering", "[render]") {
+	Scene scene{};
+	auto mirror = std::make_shared<Material>();
+	mirror->ks = {0.9f, 0.9f, 0.9f};
+	mirror->glossy = 0.6f;
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {-1, 0, -5}, "left", mirror}));
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {1, 0, -5}, "right", mirror}));
+	scene.lights.push_back({"bulb", {1, 1, 1}, {0, 3, -3}, 4});
+	scene.root->flatten();
+
+	TempFile image {"deterministic.ppm"};
+	//renders with russian roulette and path tracing, which both draw random numbers, on pools of different sizes
+	auto render = [&](unsigned thread_count, RenderMode mode, Integrator integrator, unsigned frame) {
+		ThreadPool::configure_global(PoolOptions {thread_count});
+		Renderer renderer {32, 32, image.path, 2, 8, 8, mode};
+		renderer.set_pruning(0.5f, true);
+		renderer.set_integrator(integrator);
+		renderer.set_sampler(make_sampler(SamplerType::stratified, 2));
+		renderer.set_frame(frame);
+		renderer.render(scene);
+		return renderer.color_buffer();
+	};
+	for (RenderMode mode : {RenderMode::recursive, RenderMode::wavefront}) {
+		for (Integrator integrator : {Integrator::whitted, Integrator::path_tracing}) {
+			std::vector<Color> one_thread = render(1, mode, integrator, 0);
+			std::vector<Color> three_threads = render(3, mode, integrator, 0);
+			std::vector<Color> next_frame = render(3, mode, integrator, 1);
+			bool is_same_frame = true;
+
+			for (unsigned i = 0; i < one_thread.size(); ++i) {
+				REQUIRE(one_thread[i].r == three_threads[i].r);
+				REQUIRE(one_thread[i].g == three_threads[i].g);
+				is_same_frame = is_same_frame && one_thread[i].r == next_frame[i].r;
+			}
+			//another frame draws other random numbers
+			REQUIRE_FALSE(is_same_frame);
+		}
+	}
+	//sorting the rays of a wave does not change the random numbers they draw, only the order their light is added up in
+	std::vector<Color> wavefront = render(1, RenderMode::wavefront, Integrator::whitted, 0);
+	std::vector<Color> sorted = render(1, RenderMode::sorted_wavefront, Integrator::whitted, 0);
+
+	for (unsigned i = 0; i < wavefront.size(); ++i) {
+		REQUIRE(wavefront[i].r == Approx(sorted[i].r).margin(0.0001));
+	}
+	ThreadPool::configure_global({});
+}
+
+TEST_CASE("distributed_rendering", "[render]") {
+	Scene scene{};
+	auto mirror = std::make_shared<Material>();
+	mirror->ks = {0.9f, 0.9f, 0.9f};
+	mirror->glossy = 0.6f;
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {-1, 0, -5}, "left", mirror}));
+	scene.root->add_child(std::make_shared<Sphere>(Sphere {1, {1, 0, -5}, "right", mirror}));
+	scene.lights.push_back({"bulb", {1, 1, 1}, {0, 3, -3}, 4});
+	scene.root->flatten();
+
+	auto configure = [](Renderer& renderer) {
+		renderer.set_integrator(Integrator::path_tracing);
+		renderer.set_sampler(make_sampler(SamplerType::stratified, 2));
+	};
+	TempFile local_image {"distributed_local.ppm"};
+	TempFile distributed_image {"distributed.ppm"};
+	Renderer local {40, 40, local_image.path, 2, 8, 8};
+	configure(local);
+	local.render_rect(scene, {0, 0, 40, 40});
+
+	//a straggler factor of 0 sends every running tile to a second worker as soon as no other tile is left
+	for (float straggler_factor : {3.0f, 0.0f}) {
+		Renderer coordinator {40, 40, distributed_image.path, 2, 8, 8};
+		configure(coordinator);
+		DistributedStats stats = render_distributed(coordinator, scene, {3, 1, 16, straggler_factor});
+		unsigned worker_tiles = 0;
+
+		for (unsigned tiles : stats.worker_tiles) {
+			worker_tiles += tiles;
+		}
+		REQUIRE(9 == stats.tile_count);
+		REQUIRE(9 == worker_tiles);
+		REQUIRE(0 == stats.lost_workers);
+
+		for (unsigned i = 0; i < 40 * 40; ++i) {
+			REQUIRE(local.color_buffer()[i].r == coordinator.color_buffer()[i].r);
+			REQUIRE(local.color_buffer()[i].b == coordinator.color_buffer()[i].b);
+		}
+	}
+}
+
+TEST_CASE("animation_frames", "[render]") {
+	TempFile sdf_file {"animation.sdf"};
+	std::vector<TempFile> frame_files;
+
+	for (unsigned frame = 0; frame <= 2; ++frame) {
+		frame_files.emplace_back(frame_file_name("animation_##.ppm", frame, true));
+	}
+	std::ofstream sdf {sdf_file.path};
+	sdf << "define material white 1 1 1 1 1 1 1 1 1 0 0 1 1\n"
+	    << "define shape sphere ball 0 0 0 1 white\n"
+	    << "define shape box floor -5 -3 -10 5 -2 0 white\n"
+	    << "transform ball translate 0 0 -5\n"
+	    << "define camera eye 60 0 0 0 0 0 0\n"
+	    << "key 0 transform ball translate 0 0 0\n"
+	    << "key 10 transform ball translate 4 0 0\n"
+	    << "key 0 camera eye 60 0 0 0 0 0 0\n"
+	    << "key 10 camera eye 40 0 2 0 0 0 0\n"
+	    << "render eye " << (std::filesystem::temp_directory_path() / "raytracer_animation_##.ppm").string() << " 16 16 0 2\n";
+	sdf.close();
+	Scene scene = load_scene(sdf_file.path);
+	REQUIRE(1 == scene.render_commands.size());
+	REQUIRE(16 == scene.render_commands[0].width);
+	REQUIRE(2 == scene.render_commands[0].last_frame);
+
+	//the keys move the ball on top of its transformation and the hierarchy is refitted around it
+	apply_frame(scene, 5);
+	HitPoint hit = scene.root->intersect(Ray {{2, 0, 0}, {0, 0, -1}});
+	REQUIRE(hit.does_intersect);
+	REQUIRE(hit.distance == Approx(4).margin(0.01f));
+	REQUIRE_FALSE(scene.root->intersect(Ray {{0, 0, 0}, {0, 0, -1}}).does_intersect);
+	REQUIRE(scene.camera.fov_x == Approx(50));
+	REQUIRE(scene.camera.position.y == Approx(1));
+
+	//frames after the last key keep it
+	apply_frame(scene, 20);
+	REQUIRE(scene.root->intersect(Ray {{4, 0, 0}, {0, 0, -1}}).does_intersect);
+	REQUIRE(scene.camera.fov_x == Approx(40));
+
+	REQUIRE("animation_03.ppm" == frame_file_name("animation_##.ppm", 3, true));
+	REQUIRE("frames/out_0012.ppm" == frame_file_name("frames/out.ppm", 12, true));
+	REQUIRE("out.ppm" == frame_file_name("out.ppm", 12, false));
+
+	Renderer renderer {16, 16, "", 1, 1};
+	render_animation(renderer, scene, scene.render_commands[0]);
+	REQUIRE(std::ifstream {frame_files[2].path}.good());
+}
+
 TEST_CASE("find_scene_material", "[scene]") {
 	std::istringstream words_stream("red 1 2 3 4 5 6 7 8 9 10");
 	auto mat = load_mat(words_stream);